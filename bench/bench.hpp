@@ -0,0 +1,98 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace CipherMesh {
+namespace Bench {
+
+class Stopwatch {
+public:
+    Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    }
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// One measurement, collected for the machine-readable report
+struct Result {
+    std::string suite;   // e.g. "search"
+    std::string name;    // case within the suite, e.g. "user4242"
+    int size = 0;        // entry count the case ran at (0 when not applicable)
+    std::string metric;  // e.g. "median_ms", "entries_per_sec"
+    double value = 0;
+    std::string unit;
+};
+
+void recordResult(const Result& result);
+// Writes every recorded result, plus build information, to a JSON file
+bool writeResultsJson(const std::string& path);
+
+// Creates a scratch vault database at 'path' holding one group ("Bench")
+// with 'entryCount' entries and 'locationsPerEntry' URL locations each.
+// Returns the id of the populated group.
+int populateBenchDatabase(const std::string& path, int entryCount, int locationsPerEntry);
+
+// Measures Database::getEntriesForGroup (what MainWindow::onGroupSelected
+// pays when a group is opened) for each requested group size.
+void runGroupOpenBench(const std::vector<int>& sizes);
+
+// Measures Database::searchEntries (search-as-you-type) for a few terms.
+void runSearchBench(const std::vector<int>& sizes);
+
+// Measures Database::findEntriesByLocation (autofill lookup) for an exact
+// URL, another page on the same host, and a sibling subdomain.
+void runLocationBench(const std::vector<int>& sizes);
+
+// Measures Database::storeEntries (one transaction) and, for up to 1000
+// rows, Database::storeEntry (one transaction per entry).
+void runInsertBench(const std::vector<int>& sizes);
+
+// Time and heap allocations per Crypto encrypt/decrypt call, for the
+// vector-returning API and the caller-provided-buffer overloads.
+void runCryptoBench(int iterations);
+
+// Crypto::deriveKey with the default (interactive) parameters.
+void runKdfBench(int iterations);
+
+// Vault::getEntries / searchEntries / findEntriesByLocation served from the
+// in-memory MetadataIndex versus SQLite, plus unlock time including the build.
+void runMetadataIndexBench(const std::vector<int>& sizes);
+
+// Measures Vault::importGroupEntries (receiving a shared group) and reports
+// throughput in entries/sec, then times exporting the group back out.
+// Both include password encryption/decryption.
+void runImportBench(const std::vector<int>& sizes);
+
+// Measures Vault::rotateGroupKey on a group of each size whose entries also
+// have password history, and reports throughput in entries/sec.
+void runKeyRotationBench(const std::vector<int>& sizes);
+
+// Measures Vault::getDecryptedPassword (autofill / copy password) over
+// entries spread across 'groups' groups and prints the key cache hit rate.
+void runPasswordFetchBench(int groups, int lookups);
+
+// Master password change on a vault with each of the given group counts:
+// key derivation (on the worker), re-wrapping the group keys and the single
+// commit, next to writing the same key rows with one commit per group.
+void runRekeyBench(const std::vector<int>& groupCounts);
+
+// VaultService::handleRequest round-trips as the native host performs them:
+// parse the request text, handle it, serialize the response.
+void runServiceBench(int entryCount, int requests);
+
+#ifdef CIPHERMESH_BENCH_P2P
+// Encoding/decoding of the P2P "group-data" message (shared group transfer).
+void runP2PSerializationBench(const std::vector<int>& sizes);
+#endif
+
+// Two-process check: a forked writer adds 'writes' entries through Vault
+// while this process serves GET_CREDENTIALS through VaultService against the
+// same file. Returns non-zero if either side saw a failure (e.g. SQLITE_BUSY).
+int runConcurrencyStress(int writes);
+
+}
+}
@@ -0,0 +1,113 @@
+#include "bench.hpp"
+#include "vault.hpp"
+#include "vault_service.hpp"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace CipherMesh {
+namespace Bench {
+
+namespace {
+const char* kStressPassword = "stress-master-password";
+const char* kStressUrl = "https://stress.example.com/login";
+}
+
+// Writer side: a second process opening the same vault file and adding
+// entries one transaction at a time, as the desktop app does.
+static int runWriter(const std::string& path, int writes) {
+    Core::Vault vault;
+    if (!vault.loadVault(path, kStressPassword) || !vault.setActiveGroup("Personal")) {
+        std::cerr << "writer: failed to open vault" << std::endl;
+        return 2;
+    }
+    int failures = 0;
+    for (int i = 0; i < writes; ++i) {
+        Core::VaultEntry entry;
+        entry.title = "Stress " + std::to_string(i);
+        entry.username = "writer" + std::to_string(i);
+        entry.locations.push_back(Core::Location(-1, "URL", "https://w" + std::to_string(i) + ".example.com"));
+        if (!vault.addEntry(entry, "pw" + std::to_string(i))) {
+            ++failures;
+        }
+    }
+    if (failures > 0) {
+        std::cerr << "writer: " << failures << " of " << writes << " writes failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int runConcurrencyStress(int writes) {
+    const std::string path = "ciphermesh-stress.db";
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+    {
+        Core::Vault seed;
+        seed.setKdfTargetMs(0); // keep setup and unlocks cheap
+        if (!seed.createNewVault(path, kStressPassword) || !seed.setActiveGroup("Personal")) {
+            std::cerr << "stress: failed to create vault" << std::endl;
+            return 1;
+        }
+        Core::VaultEntry entry;
+        entry.title = "Autofill target";
+        entry.username = "reader";
+        entry.locations.push_back(Core::Location(-1, "URL", kStressUrl));
+        seed.addEntry(entry, "reader-password");
+    }
+
+    pid_t writer = fork();
+    if (writer < 0) {
+        std::perror("fork");
+        return 1;
+    }
+    if (writer == 0) {
+        _exit(runWriter(path, writes));
+    }
+
+    // Reader side: the native-messaging host serving autofill requests
+    VaultService service;
+    json verify = { {"action", "VERIFY_MASTER_PASSWORD"}, {"masterPassword", kStressPassword}, {"vaultPath", path} };
+    bool verified = service.handleRequest(verify).value("status", "") == "success";
+
+    json request = { {"action", "GET_CREDENTIALS"}, {"url", kStressUrl}, {"username", "reader"} };
+    std::vector<double> latencies;
+    int readFailures = 0;
+    int status = 0;
+    while (verified) {
+        Stopwatch sw;
+        json response = service.handleRequest(request);
+        latencies.push_back(sw.elapsedMs());
+        if (response.value("status", "") != "success") {
+            if (++readFailures == 1) {
+                std::cerr << "reader: " << response.value("error", "unknown error") << std::endl;
+            }
+        }
+        if (waitpid(writer, &status, WNOHANG) == writer) break;
+    }
+    if (!verified) {
+        waitpid(writer, &status, 0);
+    }
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+
+    bool writerOk = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "concurrency_stress (" << writes << " writes vs GET_CREDENTIALS reads)" << std::endl;
+    std::printf("  writer: %s\n", writerOk ? "ok" : "FAILED");
+    std::printf("  reader: %zu requests, %d failed", latencies.size(), readFailures);
+    if (!latencies.empty()) {
+        std::printf(", p50 %.2f ms, p99 %.2f ms, max %.2f ms",
+                    latencies[latencies.size() / 2],
+                    latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)],
+                    latencies.back());
+    }
+    std::printf("\n");
+    return (verified && writerOk && readFailures == 0) ? 0 : 1;
+}
+
+}
+}
@@ -0,0 +1,107 @@
+#include "bench.hpp"
+#include "crypto.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+// Counts heap allocations made through operator new while enabled. Memory
+// from sodium_malloc (SecureBuffer) is deliberately not counted.
+static std::atomic<bool> g_countAllocations(false);
+static std::atomic<size_t> g_allocations(0);
+
+void* operator new(std::size_t size) {
+    if (g_countAllocations.load(std::memory_order_relaxed)) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace CipherMesh {
+namespace Bench {
+
+template <typename Op>
+static void measure(const char* name, int iterations, Op op) {
+    op(); // warm up (pool pages, lazy init)
+    g_allocations = 0;
+    g_countAllocations = true;
+    Stopwatch sw;
+    for (int i = 0; i < iterations; ++i) {
+        op();
+    }
+    double ms = sw.elapsedMs();
+    g_countAllocations = false;
+    double usPerOp = ms * 1000.0 / iterations;
+    double allocsPerOp = static_cast<double>(g_allocations.load()) / iterations;
+    std::printf("  %-44s %8.3f us/op  %5.2f allocs/op\n", name, usPerOp, allocsPerOp);
+    recordResult({"crypto", name, 0, "us_per_op", usPerOp, "us"});
+    recordResult({"crypto", name, 0, "allocs_per_op", allocsPerOp, "allocs"});
+}
+
+void runCryptoBench(int iterations) {
+    using Core::Crypto;
+    std::cout << "crypto (16-byte password, " << iterations << " iterations)" << std::endl;
+
+    Core::SecureBuffer key = Crypto::generateKey();
+    const std::string password = "correct-horse-42";
+    const unsigned char* plain = reinterpret_cast<const unsigned char*>(password.data());
+    std::vector<unsigned char> blob = Crypto::encrypt(password, key);
+
+    unsigned char ciphertext[128];
+    unsigned char plaintext[128];
+
+    measure("encrypt(std::string) -> vector", iterations, [&] {
+        std::vector<unsigned char> out = Crypto::encrypt(password, key);
+    });
+    measure("encrypt(ptr, len) -> caller buffer", iterations, [&] {
+        Crypto::encrypt(plain, password.size(), key, ciphertext, sizeof(ciphertext));
+    });
+    measure("decrypt(vector) -> SecureBuffer", iterations, [&] {
+        Core::SecureBuffer out = Crypto::decrypt(blob, key);
+    });
+    measure("decryptToString(vector) -> std::string", iterations, [&] {
+        std::string out = Crypto::decryptToString(blob, key);
+    });
+    measure("decrypt(ptr, len) -> caller buffer", iterations, [&] {
+        Crypto::decrypt(blob.data(), blob.size(), key, plaintext, sizeof(plaintext));
+    });
+    measure("unwrap group key (decrypt 32-byte key)", iterations, [&] {
+        static std::vector<unsigned char> wrapped = Crypto::encrypt(key, key);
+        Core::SecureBuffer out = Crypto::decrypt(wrapped, key);
+    });
+}
+
+void runKdfBench(int iterations) {
+    using Core::Crypto;
+    Core::KdfParams params;
+    std::cout << "kdf (Crypto::deriveKey, Argon2id ops=" << params.opsLimit << " mem=" << (params.memLimit >> 20)
+              << " MiB, median of " << iterations << ")" << std::endl;
+
+    std::vector<unsigned char> salt = Crypto::randomBytes(Crypto::SALT_SIZE);
+    std::vector<double> timings;
+    for (int i = 0; i < iterations; ++i) {
+        Stopwatch sw;
+        Core::SecureBuffer key = Crypto::deriveKey("bench-master-password", salt, params);
+        timings.push_back(sw.elapsedMs());
+    }
+    std::sort(timings.begin(), timings.end());
+    std::printf("  deriveKey: %9.2f ms\n", timings[iterations / 2]);
+    recordResult({"kdf", "deriveKey_interactive", 0, "median_ms", timings[iterations / 2], "ms"});
+}
+
+}
+}
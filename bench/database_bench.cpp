@@ -0,0 +1,211 @@
+#include "bench.hpp"
+#include "database.hpp"
+#include "url_matcher.hpp"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace CipherMesh {
+namespace Bench {
+
+int populateBenchDatabase(const std::string& path, int entryCount, int locationsPerEntry) {
+    std::remove(path.c_str());
+    int groupId = -1;
+    {
+        Core::Database db;
+        db.open(path);
+        db.createTables();
+        std::vector<unsigned char> fakeKey(64, 0x42);
+        db.storeEncryptedGroup("Bench", fakeKey, "me");
+        groupId = db.getGroupId("Bench");
+    }
+
+    // Bulk-load through a raw connection in one transaction so that setup
+    // time does not dominate the run.
+    sqlite3* raw = nullptr;
+    if (sqlite3_open(path.c_str(), &raw) != SQLITE_OK) {
+        throw std::runtime_error("Cannot open bench database");
+    }
+    sqlite3_exec(raw, "BEGIN;", nullptr, nullptr, nullptr);
+    sqlite3_stmt* entryStmt = nullptr;
+    sqlite3_stmt* locStmt = nullptr;
+    sqlite3_prepare_v2(raw, "INSERT INTO entries (group_id, title, username, notes, encrypted_password) VALUES (?, ?, ?, ?, ?);", -1, &entryStmt, nullptr);
+    sqlite3_prepare_v2(raw, "INSERT INTO locations (entry_id, type, value, host_key) VALUES (?, 'URL', ?, ?);", -1, &locStmt, nullptr);
+    std::vector<unsigned char> fakePassword(56, 0x17);
+    for (int i = 0; i < entryCount; ++i) {
+        std::string title = "Entry " + std::to_string(i);
+        std::string username = "user" + std::to_string(i) + "@example.com";
+        sqlite3_bind_int(entryStmt, 1, groupId);
+        sqlite3_bind_text(entryStmt, 2, title.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(entryStmt, 3, username.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(entryStmt, 4, "", -1, SQLITE_STATIC);
+        sqlite3_bind_blob(entryStmt, 5, fakePassword.data(), fakePassword.size(), SQLITE_STATIC);
+        sqlite3_step(entryStmt);
+        sqlite3_reset(entryStmt);
+        sqlite3_int64 entryId = sqlite3_last_insert_rowid(raw);
+        for (int l = 0; l < locationsPerEntry; ++l) {
+            // One registrable domain per entry, as in a real vault
+            std::string url = "https://site" + std::to_string(i) + "-" + std::to_string(l) + ".example" + std::to_string(i) + ".com/login";
+            sqlite3_bind_int64(locStmt, 1, entryId);
+            std::string hostKey = Core::UrlMatcher::hostKeyForLocation("URL", url);
+            sqlite3_bind_text(locStmt, 2, url.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(locStmt, 3, hostKey.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_step(locStmt);
+            sqlite3_reset(locStmt);
+        }
+    }
+    sqlite3_finalize(entryStmt);
+    sqlite3_finalize(locStmt);
+    sqlite3_exec(raw, "COMMIT;", nullptr, nullptr, nullptr);
+    sqlite3_close(raw);
+    return groupId;
+}
+
+void runGroupOpenBench(const std::vector<int>& sizes) {
+    const int runs = 5;
+    std::cout << "group_open (Database::getEntriesForGroup, 2 locations/entry, median of " << runs << ")" << std::endl;
+    for (int size : sizes) {
+        std::string path = "ciphermesh-bench-" + std::to_string(size) + ".db";
+        int groupId = populateBenchDatabase(path, size, 2);
+
+        Core::Database db;
+        db.open(path);
+        std::vector<double> timings;
+        size_t rows = 0;
+        for (int r = 0; r < runs; ++r) {
+            Stopwatch sw;
+            std::vector<Core::VaultEntry> entries = db.getEntriesForGroup(groupId);
+            timings.push_back(sw.elapsedMs());
+            rows = entries.size();
+        }
+        db.close();
+        std::remove(path.c_str());
+
+        std::sort(timings.begin(), timings.end());
+        std::printf("  %7d entries: %9.2f ms  (%zu rows)\n", size, timings[runs / 2], rows);
+        recordResult({"group_open", "getEntriesForGroup", size, "median_ms", timings[runs / 2], "ms"});
+    }
+}
+
+
+void runSearchBench(const std::vector<int>& sizes) {
+    const int runs = 21;
+    const char* terms[] = { "user4242", "site77-1", "Entry 99" };
+    std::cout << "search (Database::searchEntries, median of " << runs << ")" << std::endl;
+    for (int size : sizes) {
+        std::string path = "ciphermesh-bench-search-" + std::to_string(size) + ".db";
+        populateBenchDatabase(path, size, 2);
+
+        Core::Database db;
+        db.open(path);
+        for (const char* term : terms) {
+            std::vector<double> timings;
+            size_t hits = 0;
+            for (int r = 0; r < runs; ++r) {
+                Stopwatch sw;
+                hits = db.searchEntries(term).size();
+                timings.push_back(sw.elapsedMs());
+            }
+            std::sort(timings.begin(), timings.end());
+            std::printf("  %7d entries, \"%s\": %9.3f ms  (%zu hits)\n", size, term, timings[runs / 2], hits);
+            recordResult({"search", term, size, "median_ms", timings[runs / 2], "ms"});
+        }
+        db.close();
+        std::remove(path.c_str());
+    }
+}
+
+void runLocationBench(const std::vector<int>& sizes) {
+    const int runs = 101;
+    std::cout << "location lookup (Database::findEntriesByLocation, median of " << runs << ")" << std::endl;
+    for (int size : sizes) {
+        std::string path = "ciphermesh-bench-location-" + std::to_string(size) + ".db";
+        populateBenchDatabase(path, size, 2);
+
+        // Entries near the end of the table, so nothing benefits from row order
+        int target = size - size / 7 - 1;
+        std::string domain = "example" + std::to_string(target) + ".com";
+        std::string site = "site" + std::to_string(target) + "-1." + domain;
+        const std::pair<const char*, std::string> lookups[] = {
+            { "exact", "https://" + site + "/login" },
+            { "same_host", "https://" + site + "/account/settings" },
+            { "same_domain", "https://www." + domain + "/" },
+        };
+
+        Core::Database db;
+        db.open(path);
+        for (const auto& lookup : lookups) {
+            std::vector<double> timings;
+            size_t hits = 0;
+            for (int r = 0; r < runs; ++r) {
+                Stopwatch sw;
+                hits = db.findEntriesByLocation(lookup.second).size();
+                timings.push_back(sw.elapsedMs());
+            }
+            std::sort(timings.begin(), timings.end());
+            std::printf("  %7d entries, %-11s: %9.3f ms  (%zu hits)\n", size, lookup.first, timings[runs / 2], hits);
+            recordResult({"location_lookup", lookup.first, size, "median_ms", timings[runs / 2], "ms"});
+        }
+        db.close();
+        std::remove(path.c_str());
+    }
+}
+
+static std::vector<Core::VaultEntry> makeInsertEntries(int count) {
+    std::vector<Core::VaultEntry> entries(count);
+    for (int i = 0; i < count; ++i) {
+        entries[i].title = "Inserted " + std::to_string(i);
+        entries[i].username = "user" + std::to_string(i) + "@example.com";
+        entries[i].locations.push_back(Core::Location(-1, "URL", "https://insert" + std::to_string(i) + ".example.com/login"));
+    }
+    return entries;
+}
+
+void runInsertBench(const std::vector<int>& sizes) {
+    const int maxSingleInserts = 1000;
+    std::cout << "insert (Database::storeEntries / storeEntry, 1 location/entry)" << std::endl;
+    for (int size : sizes) {
+        std::string path = "ciphermesh-bench-insert-" + std::to_string(size) + ".db";
+        std::remove(path.c_str());
+
+        Core::Database db;
+        db.open(path);
+        db.createTables();
+        std::vector<unsigned char> fakeKey(64, 0x42);
+        db.storeEncryptedGroup("Bulk", fakeKey, "me");
+        db.storeEncryptedGroup("Single", fakeKey, "me");
+        std::vector<std::vector<unsigned char>> passwords(size, std::vector<unsigned char>(56, 0x17));
+
+        std::vector<Core::VaultEntry> entries = makeInsertEntries(size);
+        Stopwatch bulkSw;
+        db.storeEntries(db.getGroupId("Bulk"), entries, passwords);
+        double bulkMs = bulkSw.elapsedMs();
+
+        // One transaction (and fsync) per row: capped so it stays a benchmark
+        int singles = std::min(size, maxSingleInserts);
+        std::vector<Core::VaultEntry> singleEntries = makeInsertEntries(singles);
+        int singleGroup = db.getGroupId("Single");
+        Stopwatch singleSw;
+        for (int i = 0; i < singles; ++i) {
+            db.storeEntry(singleGroup, singleEntries[i], passwords[i]);
+        }
+        double singleMs = singleSw.elapsedMs();
+        db.close();
+        std::remove(path.c_str());
+        std::remove((path + "-wal").c_str());
+        std::remove((path + "-shm").c_str());
+
+        double bulkRate = size / (bulkMs / 1000.0);
+        double singleRate = singles / (singleMs / 1000.0);
+        std::printf("  %7d entries: storeEntries %9.2f ms  %10.0f entries/sec | storeEntry x%d %9.2f ms  %8.0f entries/sec\n",
+                    size, bulkMs, bulkRate, singles, singleMs, singleRate);
+        recordResult({"insert", "storeEntries", size, "entries_per_sec", bulkRate, "entries/s"});
+        recordResult({"insert", "storeEntry", singles, "entries_per_sec", singleRate, "entries/s"});
+    }
+}
+
+}
+}
@@ -0,0 +1,228 @@
+// ciphermesh-genvault: writes a synthetic vault of a chosen shape, for load
+// and scale testing. Everything except key material and nonces is derived
+// from --seed, so the same options produce the same vault contents.
+
+#include "bench.hpp"
+#include "vault.hpp"
+#include "database.hpp"
+#include "crypto.hpp"
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace CipherMesh;
+
+namespace {
+
+struct GenOptions {
+    std::string path;
+    std::string password = "genvault";
+    std::string userId = "genvault_0000000000000000";
+    unsigned long long seed = 1;
+    int groups = 10;
+    int entriesPerGroup = 1000;
+    int locationsPerEntry = 2;
+    int notesBytes = 64;
+    int historyDepth = 3;
+    int membersPerGroup = 4;
+    int kdfTargetMs = 0;
+};
+
+const char* kWords[] = {
+    "mail", "bank", "cloud", "shop", "forum", "news", "travel", "music", "video", "code",
+    "photo", "chat", "game", "health", "tax", "work", "school", "home", "energy", "media",
+};
+const char* kTlds[] = { "com", "org", "net", "io", "dev", "co.uk", "de", "fr" };
+
+void printUsage() {
+    std::cerr << "Usage: ciphermesh-genvault --out <vault.db> [options]\n"
+                 "  --password <pw>        master password (default: genvault)\n"
+                 "  --seed <n>             RNG seed for the generated content (default: 1)\n"
+                 "  --groups <n>           groups besides Personal (default: 10)\n"
+                 "  --entries <n>          entries per group (default: 1000)\n"
+                 "  --locations <n>        URL locations per entry (default: 2)\n"
+                 "  --notes-bytes <n>      notes length per entry (default: 64)\n"
+                 "  --history <n>          old passwords per entry (default: 3)\n"
+                 "  --members <n>          members per group besides the owner (default: 4)\n"
+                 "  --kdf-ms <n>           KDF calibration target, 0 = interactive (default: 0)\n";
+}
+
+bool parseOptions(int argc, char** argv, GenOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--out") options.path = value;
+        else if (arg == "--password") options.password = value;
+        else if (arg == "--seed") options.seed = std::stoull(value);
+        else if (arg == "--groups") options.groups = std::stoi(value);
+        else if (arg == "--entries") options.entriesPerGroup = std::stoi(value);
+        else if (arg == "--locations") options.locationsPerEntry = std::stoi(value);
+        else if (arg == "--notes-bytes") options.notesBytes = std::stoi(value);
+        else if (arg == "--history") options.historyDepth = std::stoi(value);
+        else if (arg == "--members") options.membersPerGroup = std::stoi(value);
+        else if (arg == "--kdf-ms") options.kdfTargetMs = std::stoi(value);
+        else return false;
+    }
+    return !options.path.empty();
+}
+
+class ContentGenerator {
+public:
+    explicit ContentGenerator(unsigned long long seed) : m_rng(seed) {}
+
+    int number(int below) { return std::uniform_int_distribution<int>(0, below - 1)(m_rng); }
+    const char* word() { return kWords[number(sizeof(kWords) / sizeof(kWords[0]))]; }
+
+    std::string text(size_t length, const char* alphabet) {
+        std::string out(length, ' ');
+        size_t size = std::char_traits<char>::length(alphabet);
+        for (char& c : out) c = alphabet[number(static_cast<int>(size))];
+        return out;
+    }
+    std::string password() {
+        return text(12 + number(12), "abcdefghijkmnopqrstuvwxyzABCDEFGHJKLMNPQRSTUVWXYZ23456789!@#$%^&*");
+    }
+    std::string notes(size_t length) {
+        return text(length, "abcdefghijklmnopqrstuvwxyz      \n");
+    }
+    // Registrable domain for the i-th site of a group
+    std::string domain(int group, int index) {
+        return std::string(word()) + std::to_string(group) + "-" + std::to_string(index) + "." +
+               kTlds[number(sizeof(kTlds) / sizeof(kTlds[0]))];
+    }
+
+private:
+    std::mt19937_64 m_rng;
+};
+
+std::vector<Core::VaultEntry> makeEntries(ContentGenerator& gen, const GenOptions& options, int group) {
+    std::vector<Core::VaultEntry> entries(options.entriesPerGroup);
+    for (int i = 0; i < options.entriesPerGroup; ++i) {
+        Core::VaultEntry& entry = entries[i];
+        std::string domain = gen.domain(group, i);
+        entry.title = std::string(gen.word()) + " " + domain;
+        entry.username = "user" + std::to_string(gen.number(100000)) + "@" + gen.word() + ".example";
+        entry.password = gen.password();
+        entry.notes = gen.notes(options.notesBytes);
+        for (int l = 0; l < options.locationsPerEntry; ++l) {
+            // First location is the login page, the rest other hosts of the same site
+            std::string host = l == 0 ? "www." + domain : std::string(gen.word()) + std::to_string(l) + "." + domain;
+            entry.locations.push_back(Core::Location(-1, "URL", "https://" + host + "/login"));
+        }
+    }
+    return entries;
+}
+
+}
+
+int main(int argc, char** argv) {
+    GenOptions options;
+    if (!parseOptions(argc, argv, options) || options.groups < 0 || options.entriesPerGroup < 0) {
+        printUsage();
+        return 2;
+    }
+
+    std::remove(options.path.c_str());
+    std::remove((options.path + "-wal").c_str());
+    std::remove((options.path + "-shm").c_str());
+
+    ContentGenerator gen(options.seed);
+    Bench::Stopwatch total;
+    std::vector<std::string> groupNames;
+    std::map<std::string, Core::SecureBuffer> groupKeys;
+    size_t entryCount = 0;
+
+    // Phase 1: keys, groups and entries through Vault. importGroupEntries
+    // writes each group in a single transaction.
+    try {
+        Core::Vault vault;
+        vault.setKdfTargetMs(options.kdfTargetMs);
+        if (!vault.createNewVault(options.path, options.password)) {
+            std::cerr << "Cannot create vault at " << options.path << std::endl;
+            return 1;
+        }
+        vault.setUserId(options.userId);
+
+        for (int g = 0; g < options.groups; ++g) {
+            std::string name = "Group " + std::to_string(g + 1);
+            if (!vault.addGroup(name)) {
+                std::cerr << "Cannot add group " << name << std::endl;
+                return 1;
+            }
+            groupNames.push_back(name);
+        }
+        for (size_t g = 0; g < groupNames.size(); ++g) {
+            std::vector<Core::VaultEntry> entries = makeEntries(gen, options, static_cast<int>(g));
+            entryCount += entries.size();
+            vault.importGroupEntries(groupNames[g], std::move(entries));
+            groupKeys.emplace(groupNames[g], vault.getGroupKey(groupNames[g]));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Generation failed: " << e.what() << std::endl;
+        return 1;
+    }
+    double entriesMs = total.elapsedMs();
+
+    // Phase 2: history and members directly through Database, one
+    // transaction per group
+    size_t historyCount = 0;
+    size_t memberCount = 0;
+    try {
+        Core::Database db;
+        db.open(options.path);
+        const long long now = std::time(nullptr);
+        const long long day = 24 * 60 * 60;
+        for (size_t g = 0; g < groupNames.size(); ++g) {
+            int groupId = db.getGroupId(groupNames[g]);
+            const Core::SecureBuffer& key = groupKeys.at(groupNames[g]);
+            Core::Transaction txn(db);
+
+            std::vector<Core::PasswordHistoryEntry> history;
+            if (options.historyDepth > 0) {
+                for (const Core::VaultEntry& entry : db.getEntriesForGroup(groupId)) {
+                    long long changedAt = now;
+                    for (int h = 0; h < options.historyDepth; ++h) {
+                        changedAt -= day * (1 + gen.number(90));
+                        std::vector<unsigned char> blob = Core::Crypto::encrypt(gen.password(), key);
+                        history.emplace_back(-1, entry.id, std::string(blob.begin(), blob.end()), changedAt);
+                    }
+                }
+                db.storePasswordHistory(history);
+                historyCount += history.size();
+            }
+
+            std::vector<Core::GroupMember> members;
+            for (int m = 0; m < options.membersPerGroup; ++m) {
+                Core::GroupMember member;
+                member.userId = "member" + std::to_string(m) + "_" + std::to_string(gen.number(1 << 30));
+                member.role = m == 0 ? "admin" : "member";
+                member.status = gen.number(10) == 0 ? "pending" : "accepted";
+                members.push_back(member);
+            }
+            if (!members.empty()) {
+                db.addGroupMembers(groupId, members);
+                memberCount += members.size();
+            }
+            txn.commit();
+        }
+        db.checkpoint(true);
+    } catch (const std::exception& e) {
+        std::cerr << "Generation failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    double totalMs = total.elapsedMs();
+    std::printf("%s: %zu groups, %zu entries, %zu history rows, %zu members\n",
+                options.path.c_str(), groupNames.size() + 1, entryCount, historyCount, memberCount);
+    std::printf("entries %.0f ms (%.0f entries/sec), total %.0f ms\n",
+                entriesMs, entryCount / (entriesMs / 1000.0), totalMs);
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "bench.hpp"
+#include "vault.hpp"
+#include "database.hpp"
+#include "crypto.hpp"
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace CipherMesh {
+namespace Bench {
+
+static std::vector<Core::VaultEntry> makeImportEntries(int count) {
+    std::vector<Core::VaultEntry> entries;
+    entries.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Core::VaultEntry entry;
+        entry.title = "Imported " + std::to_string(i);
+        entry.username = "user" + std::to_string(i) + "@example.com";
+        entry.password = "pw-" + std::to_string(i * 7919);
+        entry.locations.push_back(Core::Location(-1, "URL", "https://import" + std::to_string(i) + ".example.com/login"));
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+void runImportBench(const std::vector<int>& sizes) {
+    std::cout << "import/export (Vault::importGroupEntries / exportGroupEntries, 1 location/entry)" << std::endl;
+    for (int size : sizes) {
+        std::string path = "ciphermesh-bench-import-" + std::to_string(size) + ".db";
+        std::remove(path.c_str());
+
+        double ms = 0;
+        double exportMs = 0;
+        size_t stored = 0;
+        {
+            Core::Vault vault;
+            vault.setKdfTargetMs(0); // setup only; not what is being measured
+            if (!vault.createNewVault(path, "bench-master-password")) {
+                throw std::runtime_error("Cannot create import bench vault");
+            }
+            vault.addGroup("Imported");
+
+            std::vector<Core::VaultEntry> entries = makeImportEntries(size);
+            Stopwatch sw;
+            vault.importGroupEntries("Imported", std::move(entries));
+            ms = sw.elapsedMs();
+
+            Stopwatch exportSw;
+            stored = vault.exportGroupEntries("Imported").size();
+            exportMs = exportSw.elapsedMs();
+        }
+        std::remove(path.c_str());
+
+        std::printf("  %7d entries: import %9.2f ms  %10.0f entries/sec | export %9.2f ms  (%zu exported)\n",
+                    size, ms, size / (ms / 1000.0), exportMs, stored);
+        recordResult({"import_export", "importGroupEntries", size, "entries_per_sec", size / (ms / 1000.0), "entries/s"});
+        recordResult({"import_export", "exportGroupEntries", size, "ms", exportMs, "ms"});
+    }
+}
+
+void runKeyRotationBench(const std::vector<int>& sizes) {
+    const int historyPerEntry = 2;
+    std::cout << "group key rotation (Vault::rotateGroupKey, " << historyPerEntry << " history rows/entry)" << std::endl;
+    for (int size : sizes) {
+        std::string path = "ciphermesh-bench-rotate-" + std::to_string(size) + ".db";
+        std::remove(path.c_str());
+
+        Core::GroupKeyRotationStats stats;
+        {
+            Core::Vault vault;
+            vault.setKdfTargetMs(0); // setup only; not what is being measured
+            if (!vault.createNewVault(path, "bench-master-password")) {
+                throw std::runtime_error("Cannot create key rotation bench vault");
+            }
+            vault.addGroup("Shared");
+            vault.importGroupEntries("Shared", makeImportEntries(size));
+
+            // Older passwords, encrypted with the group key like updateEntry stores them
+            {
+                Core::SecureBuffer key = vault.getGroupKey("Shared");
+                Core::Database db;
+                db.open(path);
+                std::vector<Core::PasswordHistoryEntry> history;
+                const long long now = std::time(nullptr);
+                for (const Core::VaultEntry& entry : db.getEntriesForGroup(db.getGroupId("Shared"))) {
+                    for (int h = 0; h < historyPerEntry; ++h) {
+                        std::vector<unsigned char> blob = Core::Crypto::encrypt("old-pw-" + std::to_string(h), key);
+                        history.emplace_back(-1, entry.id, std::string(blob.begin(), blob.end()), now - h);
+                    }
+                }
+                db.storePasswordHistory(history);
+            }
+
+            stats = vault.rotateGroupKey("Shared");
+        }
+        std::remove(path.c_str());
+
+        std::printf("  %7d entries: %9.2f ms  %10.0f entries/sec  (%zu history rows, %u threads)\n",
+                    size, stats.seconds * 1000.0, stats.entriesPerSecond, stats.historyEntries, stats.threads);
+        recordResult({"key_rotation", "rotateGroupKey", size, "entries_per_sec", stats.entriesPerSecond, "entries/s"});
+    }
+}
+
+}
+}
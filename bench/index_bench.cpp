@@ -0,0 +1,80 @@
+#include "bench.hpp"
+#include "vault.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace CipherMesh {
+namespace Bench {
+
+static double medianMs(int runs, const std::function<void()>& op) {
+    std::vector<double> timings;
+    for (int r = 0; r < runs; ++r) {
+        Stopwatch sw;
+        op();
+        timings.push_back(sw.elapsedMs());
+    }
+    std::sort(timings.begin(), timings.end());
+    return timings[runs / 2];
+}
+
+void runMetadataIndexBench(const std::vector<int>& sizes) {
+    const int runs = 21;
+    std::cout << "metadata index (Vault reads served from MetadataIndex vs SQLite, median of " << runs << ")" << std::endl;
+    for (int size : sizes) {
+        std::string path = "ciphermesh-bench-index-" + std::to_string(size) + ".db";
+        std::remove(path.c_str());
+        {
+            Core::Vault vault;
+            vault.setKdfTargetMs(0); // setup only; not what is being measured
+            if (!vault.createNewVault(path, "bench-master-password")) {
+                throw std::runtime_error("Cannot create index bench vault");
+            }
+            std::vector<Core::VaultEntry> entries(size);
+            for (int i = 0; i < size; ++i) {
+                entries[i].title = "Entry " + std::to_string(i);
+                entries[i].username = "user" + std::to_string(i) + "@example.com";
+                entries[i].password = "pw";
+                entries[i].locations.push_back(Core::Location(-1, "URL", "https://login.site" + std::to_string(i) + ".com/"));
+                entries[i].locations.push_back(Core::Location(-1, "URL", "https://app.site" + std::to_string(i) + ".com/"));
+            }
+            vault.importGroupEntries("Personal", std::move(entries));
+        }
+
+        Core::Vault vault;
+        Stopwatch unlockSw;
+        if (!vault.loadVault(path, "bench-master-password") || !vault.setActiveGroup("Personal")) {
+            throw std::runtime_error("Cannot open index bench vault");
+        }
+        double unlockMs = unlockSw.elapsedMs();
+        Core::MetadataIndexStats stats = vault.getMetadataIndexStats();
+
+        std::string url = "https://www.site" + std::to_string(size / 3) + ".com/account";
+        const std::pair<const char*, std::function<void()>> reads[] = {
+            { "getEntries", [&] { vault.getEntries(); } },
+            { "searchEntries", [&] { vault.searchEntries("user4242"); } },
+            { "findEntriesByLocation", [&] { vault.findEntriesByLocation(url); } },
+        };
+        for (const auto& read : reads) {
+            vault.setMetadataIndexEnabled(true);
+            read.second(); // (re)build outside the timing
+            double indexMs = medianMs(runs, read.second);
+            vault.setMetadataIndexEnabled(false);
+            double sqliteMs = medianMs(runs, read.second);
+            std::printf("  %7d entries, %-22s index %9.3f ms | sqlite %9.3f ms\n", size, read.first, indexMs, sqliteMs);
+            recordResult({"metadata_index", std::string(read.first) + "_index", size, "median_ms", indexMs, "ms"});
+            recordResult({"metadata_index", std::string(read.first) + "_sqlite", size, "median_ms", sqliteMs, "ms"});
+        }
+        std::printf("  %7d entries, unlock incl. index build %9.2f ms  (%zu locations, %zu KiB text)\n",
+                    size, unlockMs, stats.locations, stats.textBytes / 1024);
+        recordResult({"metadata_index", "unlock_with_build", size, "ms", unlockMs, "ms"});
+        vault.lock();
+        std::remove(path.c_str());
+    }
+}
+
+}
+}
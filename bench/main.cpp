@@ -0,0 +1,54 @@
+#include "bench.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Usage: ciphermesh-bench [--json <file>] [--stress] [sizes...]
+int main(int argc, char** argv) {
+    std::vector<int> sizes;
+    std::string jsonPath;
+    bool stress = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stress") {
+            stress = true;
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            sizes.push_back(std::stoi(arg));
+        }
+    }
+
+    if (stress) {
+        return CipherMesh::Bench::runConcurrencyStress(sizes.empty() ? 2000 : sizes.front());
+    }
+    if (sizes.empty()) {
+        sizes = {1000, 10000, 100000};
+    }
+
+    try {
+        CipherMesh::Bench::runCryptoBench(100000);
+        CipherMesh::Bench::runKdfBench(5);
+        CipherMesh::Bench::runInsertBench(sizes);
+        CipherMesh::Bench::runGroupOpenBench(sizes);
+        CipherMesh::Bench::runSearchBench(sizes);
+        CipherMesh::Bench::runLocationBench(sizes);
+        CipherMesh::Bench::runMetadataIndexBench(sizes);
+        CipherMesh::Bench::runImportBench(sizes);
+        CipherMesh::Bench::runKeyRotationBench(sizes);
+        CipherMesh::Bench::runPasswordFetchBench(8, 10000);
+        CipherMesh::Bench::runRekeyBench({100, 500});
+        CipherMesh::Bench::runServiceBench(1000, 201);
+#ifdef CIPHERMESH_BENCH_P2P
+        CipherMesh::Bench::runP2PSerializationBench(sizes);
+#endif
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (!jsonPath.empty() && !CipherMesh::Bench::writeResultsJson(jsonPath)) {
+        return 1;
+    }
+    return 0;
+}
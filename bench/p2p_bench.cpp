@@ -0,0 +1,53 @@
+#include "bench.hpp"
+#include "groupdatacodec.hpp"
+#include <QJsonDocument>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace CipherMesh {
+namespace Bench {
+
+void runP2PSerializationBench(const std::vector<int>& sizes) {
+    const int runs = 5;
+    std::cout << "p2p group-data (encodeGroupData + compact JSON / parse + decodeGroupData, median of " << runs << ")" << std::endl;
+    std::vector<unsigned char> groupKey(32, 0x5a);
+    for (int size : sizes) {
+        std::vector<Core::VaultEntry> entries(size);
+        for (int i = 0; i < size; ++i) {
+            entries[i].title = "Shared " + std::to_string(i);
+            entries[i].username = "user" + std::to_string(i) + "@example.com";
+            entries[i].password = "pw-" + std::to_string(i * 7919);
+            entries[i].notes = "note " + std::to_string(i);
+            entries[i].locations.push_back(Core::Location(-1, "URL", "https://shared" + std::to_string(i) + ".example.com/login"));
+        }
+
+        // Same steps as WebRTCService::sendGroupData / handleP2PMessage
+        std::vector<double> encodeTimings, decodeTimings;
+        QByteArray wire;
+        size_t decoded = 0;
+        for (int r = 0; r < runs; ++r) {
+            Stopwatch encodeSw;
+            wire = QJsonDocument(P2P::encodeGroupData("Shared", groupKey, entries)).toJson(QJsonDocument::Compact);
+            encodeTimings.push_back(encodeSw.elapsedMs());
+
+            Stopwatch decodeSw;
+            QString groupName;
+            std::vector<unsigned char> key;
+            std::vector<Core::VaultEntry> received;
+            P2P::decodeGroupData(QJsonDocument::fromJson(wire).object(), groupName, key, received);
+            decodeTimings.push_back(decodeSw.elapsedMs());
+            decoded = received.size();
+        }
+        std::sort(encodeTimings.begin(), encodeTimings.end());
+        std::sort(decodeTimings.begin(), decodeTimings.end());
+        std::printf("  %7d entries: encode %9.2f ms | decode %9.2f ms  (%lld bytes, %zu decoded)\n",
+                    size, encodeTimings[runs / 2], decodeTimings[runs / 2], static_cast<long long>(wire.size()), decoded);
+        recordResult({"p2p_group_data", "encode", size, "median_ms", encodeTimings[runs / 2], "ms"});
+        recordResult({"p2p_group_data", "decode", size, "median_ms", decodeTimings[runs / 2], "ms"});
+        recordResult({"p2p_group_data", "message_size", size, "bytes", static_cast<double>(wire.size()), "bytes"});
+    }
+}
+
+}
+}
@@ -0,0 +1,64 @@
+#include "bench.hpp"
+#include "vault.hpp"
+#include "crypto.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace CipherMesh {
+namespace Bench {
+
+void runPasswordFetchBench(int groups, int lookups) {
+    std::string path = "ciphermesh-bench-password.db";
+    std::remove(path.c_str());
+    {
+        Core::Vault vault;
+        vault.setKdfTargetMs(0); // setup only; not what is being measured
+        if (!vault.createNewVault(path, "bench-master-password")) {
+            throw std::runtime_error("Cannot create password bench vault");
+        }
+
+        // A few entries per group, spread over more groups than an autofill
+        // session typically touches
+        std::vector<int> entryIds;
+        for (int g = 0; g < groups; ++g) {
+            std::string groupName = "Group " + std::to_string(g);
+            vault.addGroup(groupName);
+            std::vector<Core::VaultEntry> entries(4);
+            for (size_t i = 0; i < entries.size(); ++i) {
+                entries[i].title = groupName + " entry " + std::to_string(i);
+                entries[i].username = "user" + std::to_string(i);
+                entries[i].password = "pw-" + std::to_string(g) + "-" + std::to_string(i);
+            }
+            vault.importGroupEntries(groupName, std::move(entries));
+            vault.setActiveGroup(groupName);
+            for (const Core::VaultEntry& entry : vault.getEntries()) {
+                entryIds.push_back(entry.id);
+            }
+        }
+
+        Stopwatch sw;
+        for (int i = 0; i < lookups; ++i) {
+            std::string password = vault.getDecryptedPassword(entryIds[i % entryIds.size()]);
+            Core::Crypto::secureWipe(password);
+        }
+        double ms = sw.elapsedMs();
+
+        Core::GroupKeyCacheStats stats = vault.getGroupKeyCacheStats();
+        double hitRate = 100.0 * stats.hits / std::max<size_t>(1, stats.hits + stats.misses);
+        std::cout << "password fetch (Vault::getDecryptedPassword, " << groups << " groups)" << std::endl;
+        std::printf("  %7d lookups: %9.2f ms  %8.2f us/lookup  (key cache %zu hits, %zu misses, %.1f%% hit rate)\n",
+                    lookups, ms, ms * 1000.0 / lookups, stats.hits, stats.misses, hitRate);
+        recordResult({"password_fetch", "getDecryptedPassword", lookups, "us_per_op", ms * 1000.0 / lookups, "us"});
+        recordResult({"password_fetch", "getDecryptedPassword", lookups, "key_cache_hit_rate", hitRate, "%"});
+        Core::SecureBufferPoolStats pool = Core::SecureBuffer::getPoolStats();
+        std::printf("  secure pool: %zu pages, %zu slots in use, %zu large buffers\n",
+                    pool.pages, pool.slotsInUse, pool.largeAllocations);
+    }
+    std::remove(path.c_str());
+}
+
+}
+}
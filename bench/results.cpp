@@ -0,0 +1,76 @@
+#include "bench.hpp"
+#include <nlohmann/json.hpp>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+#ifndef CIPHERMESH_BUILD_TYPE
+#define CIPHERMESH_BUILD_TYPE ""
+#endif
+#ifndef CIPHERMESH_GIT_REVISION
+#define CIPHERMESH_GIT_REVISION ""
+#endif
+
+using json = nlohmann::json;
+
+namespace CipherMesh {
+namespace Bench {
+
+static std::vector<Result>& results() {
+    static std::vector<Result> recorded;
+    return recorded;
+}
+
+void recordResult(const Result& result) {
+    results().push_back(result);
+}
+
+bool writeResultsJson(const std::string& path) {
+    char timestamp[32] = "";
+    std::time_t now = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    json report;
+    report["schema"] = 1;
+    report["timestamp"] = timestamp;
+    report["build"] = {
+        {"revision", CIPHERMESH_GIT_REVISION},
+        {"type", CIPHERMESH_BUILD_TYPE},
+#if defined(__clang__)
+        {"compiler", "clang " __clang_version__},
+#elif defined(__GNUC__)
+        {"compiler", "gcc " __VERSION__},
+#elif defined(_MSC_VER)
+        {"compiler", "msvc " + std::to_string(_MSC_VER)},
+#endif
+#ifdef NDEBUG
+        {"assertions", false},
+#else
+        {"assertions", true},
+#endif
+    };
+
+    json list = json::array();
+    for (const Result& r : results()) {
+        list.push_back({
+            {"suite", r.suite},
+            {"name", r.name},
+            {"size", r.size},
+            {"metric", r.metric},
+            {"value", r.value},
+            {"unit", r.unit},
+        });
+    }
+    report["results"] = list;
+
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Cannot write " << path << std::endl;
+        return false;
+    }
+    out << report.dump(2) << std::endl;
+    return static_cast<bool>(out);
+}
+
+}
+}
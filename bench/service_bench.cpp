@@ -0,0 +1,77 @@
+#include "bench.hpp"
+#include "vault.hpp"
+#include "vault_service.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace CipherMesh {
+namespace Bench {
+
+namespace {
+const char* kServicePassword = "bench-master-password";
+}
+
+void runServiceBench(int entryCount, int requests) {
+    const std::string path = "ciphermesh-bench-service.db";
+    std::remove(path.c_str());
+    {
+        Core::Vault vault;
+        vault.setKdfTargetMs(0); // setup only; not what is being measured
+        if (!vault.createNewVault(path, kServicePassword)) {
+            throw std::runtime_error("Cannot create service bench vault");
+        }
+        std::vector<Core::VaultEntry> entries(entryCount);
+        for (int i = 0; i < entryCount; ++i) {
+            entries[i].title = "Site " + std::to_string(i);
+            entries[i].username = "user" + std::to_string(i) + "@example.com";
+            entries[i].password = "pw-" + std::to_string(i);
+            // Four accounts per site, so a lookup without username returns several
+            entries[i].locations.push_back(Core::Location(-1, "URL", "https://site" + std::to_string(i / 4) + ".org/login"));
+        }
+        vault.importGroupEntries("Personal", std::move(entries));
+    }
+
+    std::cout << "vault-service (VaultService::handleRequest round-trip, " << entryCount << " entries, median of "
+              << requests << ")" << std::endl;
+    {
+        VaultService service;
+        json verify = { {"action", "VERIFY_MASTER_PASSWORD"}, {"masterPassword", kServicePassword}, {"vaultPath", path} };
+        if (service.handleRequest(verify).value("status", "") != "success") {
+            throw std::runtime_error("Cannot unlock service bench vault");
+        }
+
+        std::string url = "https://site" + std::to_string(entryCount / 8) + ".org/login";
+        std::string username = "user" + std::to_string(entryCount / 8 * 4) + "@example.com";
+        const std::pair<const char*, json> cases[] = {
+            { "PING", { {"action", "PING"} } },
+            { "LIST_GROUPS", { {"action", "LIST_GROUPS"} } },
+            { "GET_CREDENTIALS", { {"action", "GET_CREDENTIALS"}, {"url", url}, {"username", username} } },
+            { "GET_CREDENTIALS_multiple", { {"action", "GET_CREDENTIALS"}, {"url", url} } },
+        };
+
+        for (const auto& c : cases) {
+            // What the native host does per message: parse, handle, serialize
+            std::string requestText = c.second.dump();
+            std::vector<double> timings;
+            std::string status;
+            for (int r = 0; r < requests; ++r) {
+                Stopwatch sw;
+                json response = service.handleRequest(json::parse(requestText));
+                std::string responseText = response.dump();
+                timings.push_back(sw.elapsedMs());
+                status = response.value("status", "");
+            }
+            std::sort(timings.begin(), timings.end());
+            double medianUs = timings[requests / 2] * 1000.0;
+            std::printf("  %-26s %9.2f us  (%s)\n", c.first, medianUs, status.c_str());
+            recordResult({"vault_service", c.first, entryCount, "median_us", medianUs, "us"});
+        }
+    }
+    std::remove(path.c_str());
+}
+
+}
+}
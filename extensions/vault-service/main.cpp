@@ -1,6 +1,7 @@
 #include "vault_service.hpp"
 #include <iostream>
 #include <cstring>
+#include <mutex>
 #include <unistd.h>
 #include <nlohmann/json.hpp>
 
@@ -41,17 +42,77 @@ std::string readNativeMessage() {
     return message;
 }
 
+// Replies can come from an unlock worker thread as well as the main loop
+static std::mutex g_writeMutex;
+
 void writeNativeMessage(const std::string& message) {
+    std::lock_guard<std::mutex> guard(g_writeMutex);
     uint32_t length = message.length();
     std::cout.write(reinterpret_cast<const char*>(&length), 4);
     std::cout.write(message.c_str(), length);
     std::cout.flush();
 }
 
+// Sends a VaultService response, converted to the native-host format when
+// the request carried a requestId
+void sendResponse(int requestId, const json& serviceResponse) {
+    // Convert to native-host format if requestId is present
+    json response;
+    if (requestId != -1) {
+        // Native-host protocol format
+        response["requestId"] = requestId;
+        std::string status = serviceResponse.value("status", "error");
+        
+        if (status == "success" || status == "multiple") {
+            response["success"] = true;
+            // Extract data fields
+            json data;
+            if (serviceResponse.contains("verified")) {
+                data["verified"] = serviceResponse["verified"];
+            }
+            if (serviceResponse.contains("entries")) {
+                data["entries"] = serviceResponse["entries"];
+            }
+            if (serviceResponse.contains("nextPageToken")) {
+                data["nextPageToken"] = serviceResponse["nextPageToken"];
+            }
+            if (serviceResponse.contains("groups")) {
+                data["groups"] = serviceResponse["groups"];
+            }
+            if (serviceResponse.contains("credentials")) {
+                // Multiple credentials case
+                data["credentials"] = serviceResponse["credentials"];
+                data["multiple"] = true;
+            }
+            if (serviceResponse.contains("username")) {
+                data["username"] = serviceResponse["username"];
+                data["password"] = serviceResponse["password"];
+                data["title"] = serviceResponse.value("title", "");
+            }
+            if (serviceResponse.contains("saved")) {
+                data["saved"] = serviceResponse["saved"];
+            }
+            response["data"] = data;
+        } else {
+            response["success"] = false;
+            response["error"] = serviceResponse.value("error", "Unknown error");
+        }
+    } else {
+        // Original vault-service format
+        response = serviceResponse;
+    }
+    
+    std::string responseStr = response.dump();
+    writeNativeMessage(responseStr);
+    
+    std::cerr << "[Vault Service] Response sent: " << (response.contains("success") ? (response["success"].get<bool>() ? "success" : "error") : serviceResponse["status"].get<std::string>()) << std::endl;
+}
+
 int main() {
-    // Disable buffering for immediate I/O
-    std::cin.sync_with_stdio(false);
-    std::cout.sync_with_stdio(false);
+    // Standard streams stay synchronized with stdio: unlock replies and logs
+    // are also written from the unlock worker thread, and unsynchronized
+    // iostreams are not safe to share between threads. writeNativeMessage
+    // flushes each message explicitly.
     
     VaultService service;
     
@@ -82,55 +143,9 @@ int main() {
             }
             std::cerr << std::endl;
             
-            json serviceResponse = service.handleRequest(request);
-            
-            // Convert to native-host format if requestId is present
-            json response;
-            if (requestId != -1) {
-                // Native-host protocol format
-                response["requestId"] = requestId;
-                std::string status = serviceResponse.value("status", "error");
-                
-                if (status == "success" || status == "multiple") {
-                    response["success"] = true;
-                    // Extract data fields
-                    json data;
-                    if (serviceResponse.contains("verified")) {
-                        data["verified"] = serviceResponse["verified"];
-                    }
-                    if (serviceResponse.contains("entries")) {
-                        data["entries"] = serviceResponse["entries"];
-                    }
-                    if (serviceResponse.contains("groups")) {
-                        data["groups"] = serviceResponse["groups"];
-                    }
-                    if (serviceResponse.contains("credentials")) {
-                        // Multiple credentials case
-                        data["credentials"] = serviceResponse["credentials"];
-                        data["multiple"] = true;
-                    }
-                    if (serviceResponse.contains("username")) {
-                        data["username"] = serviceResponse["username"];
-                        data["password"] = serviceResponse["password"];
-                        data["title"] = serviceResponse.value("title", "");
-                    }
-                    if (serviceResponse.contains("saved")) {
-                        data["saved"] = serviceResponse["saved"];
-                    }
-                    response["data"] = data;
-                } else {
-                    response["success"] = false;
-                    response["error"] = serviceResponse.value("error", "Unknown error");
-                }
-            } else {
-                // Original vault-service format
-                response = serviceResponse;
-            }
-            
-            std::string responseStr = response.dump();
-            writeNativeMessage(responseStr);
-            
-            std::cerr << "[Vault Service] Response sent: " << (response.contains("success") ? (response["success"].get<bool>() ? "success" : "error") : serviceResponse["status"].get<std::string>()) << std::endl;
+            service.handleRequestAsync(request, [requestId](const json& serviceResponse) {
+                sendResponse(requestId, serviceResponse);
+            });
             
         } catch (const json::exception& e) {
             std::cerr << "[Vault Service] JSON error: " << e.what() << std::endl;
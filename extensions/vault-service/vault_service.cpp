@@ -3,15 +3,27 @@
 #include "../../src/core/crypto.hpp"
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 using namespace CipherMesh::Core;
 
-VaultService::VaultService() : m_vault(nullptr) {
+namespace {
+// LIST_ENTRIES page size when the request gives none, and the most it may ask for
+const int DEFAULT_LIST_PAGE_SIZE = 100;
+const int MAX_LIST_PAGE_SIZE = 1000;
+}
+
+VaultService::VaultService() : m_vault(nullptr), m_unlockPending(false) {
 }
 
 VaultService::~VaultService() {
+    // An unlock still running refers to m_pendingVault; let it finish first
+    if (m_pendingUnlock.isValid()) {
+        m_pendingUnlock.cancel();
+        m_pendingUnlock.wait();
+    }
     if (m_vault) {
         m_vault->lock();
     }
@@ -58,15 +70,77 @@ std::string VaultService::getDefaultVaultPath() {
     return standardPath;
 }
 
+std::string VaultService::getAction(const json& request) {
+    // Support both "action" (original) and "type" (native-host protocol) fields
+    std::string action = request.value("action", "");
+    if (action.empty()) {
+        action = request.value("type", "");
+    }
+    return action;
+}
+
 json VaultService::handleRequest(const json& request) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return handleRequestLocked(request);
+}
+
+void VaultService::handleRequestAsync(const json& request, const ReplyCallback& reply) {
+    std::unique_lock<std::mutex> guard(m_mutex);
+    if (getAction(request) != "VERIFY_MASTER_PASSWORD") {
+        json response = handleRequestLocked(request);
+        guard.unlock();
+        reply(response);
+        return;
+    }
+
+    std::string masterPassword, vaultPath;
+    json error = checkVerifyRequest(request, masterPassword, vaultPath);
+    if (error.is_null() && m_unlockPending) {
+        error["status"] = "error";
+        error["error"] = "Unlock already in progress";
+    }
+    if (!error.is_null()) {
+        guard.unlock();
+        Crypto::secureWipe(masterPassword);
+        reply(error);
+        return;
+    }
+
+    std::cerr << "[Vault Service] Vault file found, unlocking in background..." << std::endl;
+    if (m_pendingUnlock.isValid()) {
+        // The previous worker has already replied; make sure it has returned
+        // before its vault is replaced
+        m_pendingUnlock.wait();
+    }
+    m_unlockPending = true;
+    m_pendingVault = std::make_unique<Vault>();
+    m_pendingUnlock = m_pendingVault->loadVaultAsync(vaultPath, masterPassword, nullptr,
+        [this, reply](UnlockResult result) {
+            json response;
+            {
+                std::lock_guard<std::mutex> completionGuard(m_mutex);
+                m_unlockPending = false;
+                if (result == UnlockResult::Unlocked) {
+                    // Password is correct, keep vault unlocked for this session
+                    m_vault = std::move(m_pendingVault);
+                    response = verifiedResponse();
+                } else if (result == UnlockResult::WrongPassword) {
+                    response = incorrectPasswordResponse();
+                } else {
+                    response["status"] = "error";
+                    response["error"] = result == UnlockResult::Cancelled ? "Unlock cancelled" : "Could not open vault";
+                }
+            }
+            reply(response);
+        });
+    Crypto::secureWipe(masterPassword);
+}
+
+json VaultService::handleRequestLocked(const json& request) {
     json response;
     
     try {
-        // Support both "action" (original) and "type" (native-host protocol) fields
-        std::string action = request.value("action", "");
-        if (action.empty()) {
-            action = request.value("type", "");
-        }
+        std::string action = getAction(request);
         
         if (action == "VERIFY_MASTER_PASSWORD") {
             return handleVerifyMasterPassword(request);
@@ -78,6 +152,8 @@ json VaultService::handleRequest(const json& request) {
             return handleSaveCredentials(request);
         } else if (action == "LIST_GROUPS") {
             return handleListGroups(request);
+        } else if (action == "LIST_ENTRIES") {
+            return handleListEntries(request);
         } else if (action == "PING") {
             response["status"] = "success";
             response["message"] = "pong";
@@ -94,40 +170,69 @@ json VaultService::handleRequest(const json& request) {
     }
 }
 
+json VaultService::checkVerifyRequest(const json& request, std::string& masterPassword, std::string& vaultPath) {
+    json response;
+    
+    // Support both "masterPassword" (original) and "password" (native-host protocol)
+    masterPassword = request.value("masterPassword", "");
+    if (masterPassword.empty()) {
+        masterPassword = request.value("password", "");
+    }
+    
+    if (masterPassword.empty()) {
+        response["status"] = "error";
+        response["error"] = "Password is required";
+        std::cerr << "[Vault Service] Error: Password is required" << std::endl;
+        return response;
+    }
+    
+    vaultPath = request.value("vaultPath", getDefaultVaultPath());
+    std::cerr << "[Vault Service] Using vault path: " << vaultPath << std::endl;
+    
+    if (vaultPath.empty()) {
+        response["status"] = "error";
+        response["error"] = "Could not determine vault path";
+        std::cerr << "[Vault Service] Error: Could not determine vault path" << std::endl;
+        return response;
+    }
+    
+    // Check if vault file exists
+    std::ifstream vaultFile(vaultPath);
+    if (!vaultFile.good()) {
+        response["status"] = "error";
+        response["error"] = "Vault file not found at: " + vaultPath;
+        std::cerr << "[Vault Service] Error: Vault file not found at: " << vaultPath << std::endl;
+        return response;
+    }
+    
+    return response;
+}
+
+json VaultService::verifiedResponse() {
+    json response;
+    response["status"] = "success";
+    response["message"] = "Master password verified";
+    response["verified"] = true;  // Add for native-host compatibility
+    std::cerr << "[Vault Service] Password verified successfully" << std::endl;
+    return response;
+}
+
+json VaultService::incorrectPasswordResponse() {
+    json response;
+    response["status"] = "error";
+    response["error"] = "Incorrect master password";
+    std::cerr << "[Vault Service] Error: Incorrect master password" << std::endl;
+    return response;
+}
+
 json VaultService::handleVerifyMasterPassword(const json& request) {
     json response;
     
     try {
-        // Support both "masterPassword" (original) and "password" (native-host protocol)
-        std::string masterPassword = request.value("masterPassword", "");
-        if (masterPassword.empty()) {
-            masterPassword = request.value("password", "");
-        }
-        
-        if (masterPassword.empty()) {
-            response["status"] = "error";
-            response["error"] = "Password is required";
-            std::cerr << "[Vault Service] Error: Password is required" << std::endl;
-            return response;
-        }
-        
-        std::string vaultPath = request.value("vaultPath", getDefaultVaultPath());
-        std::cerr << "[Vault Service] Using vault path: " << vaultPath << std::endl;
-        
-        if (vaultPath.empty()) {
-            response["status"] = "error";
-            response["error"] = "Could not determine vault path";
-            std::cerr << "[Vault Service] Error: Could not determine vault path" << std::endl;
-            return response;
-        }
-        
-        // Check if vault file exists
-        std::ifstream vaultFile(vaultPath);
-        if (!vaultFile.good()) {
-            response["status"] = "error";
-            response["error"] = "Vault file not found at: " + vaultPath;
-            std::cerr << "[Vault Service] Error: Vault file not found at: " << vaultPath << std::endl;
-            return response;
+        std::string masterPassword, vaultPath;
+        json error = checkVerifyRequest(request, masterPassword, vaultPath);
+        if (!error.is_null()) {
+            return error;
         }
         
         std::cerr << "[Vault Service] Vault file found, attempting to load..." << std::endl;
@@ -136,21 +241,15 @@ json VaultService::handleVerifyMasterPassword(const json& request) {
         std::unique_ptr<Vault> vault = std::make_unique<Vault>();
         
         // Try to load vault with master password
-        if (!vault->loadVault(vaultPath, masterPassword)) {
-            response["status"] = "error";
-            response["error"] = "Incorrect master password";
-            std::cerr << "[Vault Service] Error: Incorrect master password" << std::endl;
-            return response;
+        bool unlocked = vault->loadVault(vaultPath, masterPassword);
+        Crypto::secureWipe(masterPassword);
+        if (!unlocked) {
+            return incorrectPasswordResponse();
         }
         
         // Password is correct, keep vault unlocked for this session
         m_vault = std::move(vault);
-        
-        response["status"] = "success";
-        response["message"] = "Master password verified";
-        response["verified"] = true;  // Add for native-host compatibility
-        std::cerr << "[Vault Service] Password verified successfully" << std::endl;
-        return response;
+        return verifiedResponse();
         
     } catch (const std::exception& e) {
         response["status"] = "error";
@@ -363,3 +462,52 @@ json VaultService::handleListGroups(const json& request) {
         return response;
     }
 }
+
+json VaultService::handleListEntries(const json& request) {
+    json response;
+    
+    try {
+        if (!m_vault || m_vault->isLocked()) {
+            response["status"] = "error";
+            response["error"] = "Vault is locked. Please verify master password first.";
+            return response;
+        }
+        
+        std::string groupName = request.value("group", "");
+        int limit = std::min(request.value("limit", DEFAULT_LIST_PAGE_SIZE), MAX_LIST_PAGE_SIZE);
+        std::string pageToken = request.value("pageToken", "");
+        
+        if (groupName.empty() || !m_vault->setActiveGroup(groupName)) {
+            response["status"] = "error";
+            response["error"] = "Group not found: " + groupName;
+            return response;
+        }
+        
+        // One page per request, so a large group never has to be held at once
+        EntryPage page = m_vault->getEntriesPage(limit, pageToken);
+        
+        json entries = json::array();
+        for (const auto& entry : page.entries) {
+            json locations = json::array();
+            for (const auto& loc : entry.locations) {
+                locations.push_back({ {"type", loc.type}, {"value", loc.value} });
+            }
+            json item;
+            item["id"] = entry.id;
+            item["title"] = entry.title;
+            item["username"] = entry.username;
+            item["locations"] = locations;
+            entries.push_back(item);
+        }
+        
+        response["status"] = "success";
+        response["entries"] = entries;
+        response["nextPageToken"] = page.nextPageToken;
+        return response;
+        
+    } catch (const std::exception& e) {
+        response["status"] = "error";
+        response["error"] = std::string("Error listing entries: ") + e.what();
+        return response;
+    }
+}
@@ -2,13 +2,10 @@
 
 #include <string>
 #include <memory>
+#include <mutex>
+#include <functional>
 #include <nlohmann/json.hpp>
-
-namespace CipherMesh {
-namespace Core {
-    class Vault;
-}
-}
+#include "vault.hpp"
 
 using json = nlohmann::json;
 
@@ -17,18 +14,38 @@ public:
     VaultService();
     ~VaultService();
     
+    using ReplyCallback = std::function<void(const json&)>;
+
     // Main request handler
     json handleRequest(const json& request);
+    // Same, except that VERIFY_MASTER_PASSWORD derives the key on a worker
+    // thread and replies from there when done, so other requests keep being
+    // served meanwhile. Everything else is answered before this returns.
+    void handleRequestAsync(const json& request, const ReplyCallback& reply);
     
 private:
     std::unique_ptr<CipherMesh::Core::Vault> m_vault;
+    // Guards m_vault between the request loop and unlock completions
+    std::mutex m_mutex;
+    // Vault being unlocked on a worker thread; moved to m_vault on success
+    std::unique_ptr<CipherMesh::Core::Vault> m_pendingVault;
+    CipherMesh::Core::UnlockHandle m_pendingUnlock;
+    // True from the start of an async unlock until its reply has been built
+    bool m_unlockPending;
     
     std::string getDefaultVaultPath();
+    std::string getAction(const json& request);
+    // Validates a VERIFY_MASTER_PASSWORD request; returns an error response or null
+    json checkVerifyRequest(const json& request, std::string& masterPassword, std::string& vaultPath);
+    json verifiedResponse();
+    json incorrectPasswordResponse();
     
     // Request handlers
+    json handleRequestLocked(const json& request);
     json handleVerifyMasterPassword(const json& request);
     json handleGetCredentials(const json& request);
     json handleGetCredentialById(const json& request);
     json handleSaveCredentials(const json& request);
     json handleListGroups(const json& request);
+    json handleListEntries(const json& request);
 };
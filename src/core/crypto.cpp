@@ -2,85 +2,140 @@
 #include "crypto.hpp"
 #include <stdexcept>
 #include <string> // for std::string
+#include <algorithm>
+#include <chrono>
 
 namespace CipherMesh {
 namespace Core {
 
 // ... (all other functions: deriveKey, encrypt, decrypt, etc. remain unchanged) ...
-std::vector<unsigned char> Crypto::deriveKey(const std::string& password, const std::vector<unsigned char>& salt) {
+SecureBuffer Crypto::deriveKey(const std::string& password, const std::vector<unsigned char>& salt, const KdfParams& params) {
     if (salt.size() != SALT_SIZE) {
         throw std::runtime_error("Invalid salt size.");
     }
-    std::vector<unsigned char> key(KEY_SIZE);
+    SecureBuffer key(KEY_SIZE);
     if (crypto_pwhash(
             key.data(), key.size(),
             password.c_str(), password.length(),
             salt.data(),
-            crypto_pwhash_OPSLIMIT_INTERACTIVE,
-            crypto_pwhash_MEMLIMIT_INTERACTIVE,
-            crypto_pwhash_ALG_DEFAULT
+            params.opsLimit,
+            params.memLimit,
+            params.algorithm
         ) != 0) {
         throw std::runtime_error("Key derivation (crypto_pwhash) failed.");
     }
     return key;
 }
 
-std::vector<unsigned char> Crypto::encrypt(const std::vector<unsigned char>& plaintext, const std::vector<unsigned char>& key) {
+KdfParams Crypto::calibrateKdf(int targetMs) {
+    KdfParams params;
+    if (targetMs <= 0) {
+        return params;
+    }
+    const std::vector<unsigned char> salt = randomBytes(SALT_SIZE);
+    auto timeDerivation = [&salt](const KdfParams& p) {
+        auto start = std::chrono::steady_clock::now();
+        deriveKey("ciphermesh-kdf-calibration", salt, p);
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    double ms = timeDerivation(params);
+
+    // Argon2 time grows roughly linearly with both memory and passes
+    if (ms * 2 <= targetMs) {
+        while (params.memLimit < crypto_pwhash_MEMLIMIT_MODERATE && ms * 2 <= targetMs) {
+            params.memLimit *= 2;
+            ms *= 2;
+        }
+        ms = timeDerivation(params);
+    }
+    double msPerPass = ms / params.opsLimit;
+    unsigned long long passes = static_cast<unsigned long long>(targetMs / std::max(msPerPass, 1.0));
+    params.opsLimit = std::min<unsigned long long>(std::max<unsigned long long>(passes, params.opsLimit), 64);
+    return params;
+}
+
+SecureBuffer Crypto::generateKey() {
+    SecureBuffer key(KEY_SIZE);
+    crypto_aead_xchacha20poly1305_ietf_keygen(key.data());
+    return key;
+}
+
+size_t Crypto::encrypt(const unsigned char* plaintext, size_t length, const SecureBuffer& key, unsigned char* out, size_t outCapacity) {
     if (key.size() != KEY_SIZE) {
         throw std::runtime_error("Invalid key size for encryption.");
     }
-    std::vector<unsigned char> ciphertext(NONCE_SIZE + plaintext.size() + TAG_SIZE);
-    std::vector<unsigned char> nonce = randomBytes(NONCE_SIZE);
+    if (outCapacity < ciphertextSize(length)) {
+        throw std::runtime_error("Output buffer too small for encryption.");
+    }
+    randombytes_buf(out, NONCE_SIZE);
     unsigned long long ciphertext_len;
     if (crypto_aead_xchacha20poly1305_ietf_encrypt(
-            ciphertext.data() + NONCE_SIZE, &ciphertext_len,
-            plaintext.data(), plaintext.size(),
+            out + NONCE_SIZE, &ciphertext_len,
+            plaintext, length,
             nullptr, 0,
             nullptr,
-            nonce.data(),
+            out,
             key.data()
         ) != 0) {
         throw std::runtime_error("Encryption (crypto_aead_xchacha20poly1305_ietf_encrypt) failed.");
     }
-    std::copy(nonce.begin(), nonce.end(), ciphertext.begin());
-    ciphertext.resize(NONCE_SIZE + ciphertext_len);
-    return ciphertext;
+    return NONCE_SIZE + ciphertext_len;
 }
 
-std::vector<unsigned char> Crypto::encrypt(const std::string& plaintext, const std::vector<unsigned char>& key) {
-    std::vector<unsigned char> pt(plaintext.begin(), plaintext.end());
-    return encrypt(pt, key);
-}
-
-std::vector<unsigned char> Crypto::decrypt(const std::vector<unsigned char>& ciphertext, const std::vector<unsigned char>& key) {
+size_t Crypto::decrypt(const unsigned char* ciphertext, size_t length, const SecureBuffer& key, unsigned char* out, size_t outCapacity) {
     if (key.size() != KEY_SIZE) {
         throw std::runtime_error("Invalid key size for decryption.");
     }
-    if (ciphertext.size() < NONCE_SIZE + TAG_SIZE) {
+    if (length < NONCE_SIZE + TAG_SIZE) {
         throw std::runtime_error("Invalid ciphertext size (too small).");
     }
-    std::vector<unsigned char> nonce(ciphertext.begin(), ciphertext.begin() + NONCE_SIZE);
-    const unsigned char* encrypted_data = ciphertext.data() + NONCE_SIZE;
-    size_t encrypted_data_len = ciphertext.size() - NONCE_SIZE;
-    std::vector<unsigned char> decrypted(encrypted_data_len - TAG_SIZE);
+    if (outCapacity < plaintextSize(length)) {
+        throw std::runtime_error("Output buffer too small for decryption.");
+    }
     unsigned long long decrypted_len;
     if (crypto_aead_xchacha20poly1305_ietf_decrypt(
-            decrypted.data(), &decrypted_len,
+            out, &decrypted_len,
             nullptr,
-            encrypted_data, encrypted_data_len,
+            ciphertext + NONCE_SIZE, length - NONCE_SIZE,
             nullptr, 0,
-            nonce.data(),
+            ciphertext,
             key.data()
         ) != 0) {
         throw std::runtime_error("Decryption failed. Invalid key or tampered data.");
     }
-    decrypted.resize(decrypted_len);
+    return decrypted_len;
+}
+
+std::vector<unsigned char> Crypto::encryptBytes(const unsigned char* plaintext, size_t length, const SecureBuffer& key) {
+    std::vector<unsigned char> ciphertext(ciphertextSize(length));
+    encrypt(plaintext, length, key, ciphertext.data(), ciphertext.size());
+    return ciphertext;
+}
+
+std::vector<unsigned char> Crypto::encrypt(const std::vector<unsigned char>& plaintext, const SecureBuffer& key) {
+    return encryptBytes(plaintext.data(), plaintext.size(), key);
+}
+
+std::vector<unsigned char> Crypto::encrypt(const SecureBuffer& plaintext, const SecureBuffer& key) {
+    return encryptBytes(plaintext.data(), plaintext.size(), key);
+}
+
+std::vector<unsigned char> Crypto::encrypt(const std::string& plaintext, const SecureBuffer& key) {
+    return encryptBytes(reinterpret_cast<const unsigned char*>(plaintext.data()), plaintext.size(), key);
+}
+
+SecureBuffer Crypto::decrypt(const std::vector<unsigned char>& ciphertext, const SecureBuffer& key) {
+    SecureBuffer decrypted(plaintextSize(ciphertext.size()));
+    decrypt(ciphertext.data(), ciphertext.size(), key, decrypted.data(), decrypted.size());
     return decrypted;
 }
 
-std::string Crypto::decryptToString(const std::vector<unsigned char>& ciphertext, const std::vector<unsigned char>& key) {
-    std::vector<unsigned char> decrypted = decrypt(ciphertext, key);
-    return std::string(decrypted.begin(), decrypted.end());
+std::string Crypto::decryptToString(const std::vector<unsigned char>& ciphertext, const SecureBuffer& key) {
+    // Decrypt straight into the string; short passwords stay in its inline buffer
+    std::string decrypted(plaintextSize(ciphertext.size()), '\0');
+    decrypt(ciphertext.data(), ciphertext.size(), key, reinterpret_cast<unsigned char*>(&decrypted[0]), decrypted.size());
+    return decrypted;
 }
 
 std::vector<unsigned char> Crypto::randomBytes(size_t size) {
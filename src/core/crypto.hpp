@@ -1,12 +1,21 @@
 #pragma once
 
 #include <sodium.h> 
+#include "secure_buffer.hpp"
 #include <vector>
 #include <string>
 
 namespace CipherMesh {
 namespace Core {
 
+// Argon2 cost parameters for the master key, stored in vault_metadata. The
+// defaults are what vaults created before calibration existed were derived with.
+struct KdfParams {
+    int algorithm = crypto_pwhash_ALG_ARGON2ID13;
+    unsigned long long opsLimit = crypto_pwhash_OPSLIMIT_INTERACTIVE;
+    size_t memLimit = crypto_pwhash_MEMLIMIT_INTERACTIVE;
+};
+
 class Crypto {
 public:
     static const size_t KEY_SIZE = crypto_aead_xchacha20poly1305_ietf_KEYBYTES;
@@ -23,16 +32,36 @@ public:
         std::string customSymbols = "!@#$%^&*()_+-=[]{}|;:,.<>?"; // <-- CHANGED
     };
 
-    static std::vector<unsigned char> deriveKey(const std::string& password, const std::vector<unsigned char>& salt);
-    static std::vector<unsigned char> encrypt(const std::vector<unsigned char>& plaintext, const std::vector<unsigned char>& key);
-    static std::vector<unsigned char> encrypt(const std::string& plaintext, const std::vector<unsigned char>& key);
-    static std::vector<unsigned char> decrypt(const std::vector<unsigned char>& ciphertext, const std::vector<unsigned char>& key);
-    static std::string decryptToString(const std::vector<unsigned char>& ciphertext, const std::vector<unsigned char>& key);
+    // Keys and decrypted key material are returned as SecureBuffer (locked, wiped on destruction)
+    static SecureBuffer deriveKey(const std::string& password, const std::vector<unsigned char>& salt, const KdfParams& params = KdfParams());
+    // Times Argon2id on this machine and returns parameters that take roughly
+    // 'targetMs' per derivation, never weaker than the KdfParams defaults.
+    // Extra budget goes to memory first (up to MEMLIMIT_MODERATE), then passes.
+    static KdfParams calibrateKdf(int targetMs);
+    static SecureBuffer generateKey();
+    static std::vector<unsigned char> encrypt(const std::vector<unsigned char>& plaintext, const SecureBuffer& key);
+    static std::vector<unsigned char> encrypt(const SecureBuffer& plaintext, const SecureBuffer& key);
+    static std::vector<unsigned char> encrypt(const std::string& plaintext, const SecureBuffer& key);
+    static SecureBuffer decrypt(const std::vector<unsigned char>& ciphertext, const SecureBuffer& key);
+    static std::string decryptToString(const std::vector<unsigned char>& ciphertext, const SecureBuffer& key);
     static std::vector<unsigned char> randomBytes(size_t size);
     static void secureWipe(std::vector<unsigned char>& data);
     static void secureWipe(std::string& str);
+    static void secureWipe(SecureBuffer& buffer) { buffer.wipe(); }
+
+    // Allocation-free variants working on caller-provided buffers. The
+    // ciphertext layout is nonce || encrypted data || tag; the nonce is
+    // generated directly into 'out'. Both return the number of bytes written
+    // and throw if 'outCapacity' is too small or authentication fails.
+    static size_t ciphertextSize(size_t plaintextLength) { return NONCE_SIZE + plaintextLength + TAG_SIZE; }
+    static size_t plaintextSize(size_t ciphertextLength) { return ciphertextLength < NONCE_SIZE + TAG_SIZE ? 0 : ciphertextLength - NONCE_SIZE - TAG_SIZE; }
+    static size_t encrypt(const unsigned char* plaintext, size_t length, const SecureBuffer& key, unsigned char* out, size_t outCapacity);
+    static size_t decrypt(const unsigned char* ciphertext, size_t length, const SecureBuffer& key, unsigned char* out, size_t outCapacity);
     
     static std::string generatePassword(const PasswordOptions& options);
+
+private:
+    static std::vector<unsigned char> encryptBytes(const unsigned char* plaintext, size_t length, const SecureBuffer& key);
 };
 
 }
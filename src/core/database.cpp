@@ -1,9 +1,14 @@
 #include <sodium.h>
 #include "database.hpp"
+#include "url_matcher.hpp"
 #include <sqlite3.h>
 #include <stdexcept>
 #include <ctime>
 #include <iostream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <climits>
 
 namespace CipherMesh {
 namespace Core {
@@ -15,11 +20,71 @@ inline void check_sqlite(int rc, sqlite3* db) {
     }
 }
 
-Database::Database() : m_db(nullptr) {}
+inline std::string column_string(sqlite3_stmt* stmt, int col) {
+    const unsigned char* text = sqlite3_column_text(stmt, col);
+    return text ? std::string(reinterpret_cast<const char*>(text), sqlite3_column_bytes(stmt, col)) : std::string();
+}
+
+// Binds NULL for an empty string so optional columns stay out of indexes
+inline void bind_optional_text(sqlite3_stmt* stmt, int index, const std::string& value) {
+    if (value.empty()) {
+        sqlite3_bind_null(stmt, index);
+    } else {
+        sqlite3_bind_text(stmt, index, value.c_str(), -1, SQLITE_STATIC);
+    }
+}
+
+// Reads rows shaped as (entry columns..., location id, type, value) where all
+// rows of one entry are adjacent, folding the LEFT JOINed locations into each
+// entry so list queries need a single statement instead of one per entry.
+// When 'encryptedPasswords' is given, column 11 holds the encrypted password
+// blob and one blob is appended per entry, in the same order as the result.
+static std::vector<VaultEntry> readEntriesWithLocations(sqlite3_stmt* stmt, std::vector<std::vector<unsigned char>>* encryptedPasswords = nullptr) {
+    std::vector<VaultEntry> entries;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        int id = sqlite3_column_int(stmt, 0);
+        if (entries.empty() || entries.back().id != id) {
+            VaultEntry entry(id, column_string(stmt, 1), column_string(stmt, 2), column_string(stmt, 3));
+            entry.createdAt = sqlite3_column_int64(stmt, 4);
+            entry.lastModified = sqlite3_column_int64(stmt, 5);
+            entry.lastAccessed = sqlite3_column_int64(stmt, 6);
+            entry.passwordExpiry = sqlite3_column_int64(stmt, 7);
+            entries.push_back(std::move(entry));
+            if (encryptedPasswords) {
+                const unsigned char* blob = static_cast<const unsigned char*>(sqlite3_column_blob(stmt, 11));
+                int size = sqlite3_column_bytes(stmt, 11);
+                encryptedPasswords->emplace_back(blob, blob + size);
+            }
+        }
+        if (sqlite3_column_type(stmt, 8) != SQLITE_NULL) {
+            entries.back().locations.emplace_back(sqlite3_column_int(stmt, 8), column_string(stmt, 9), column_string(stmt, 10));
+        }
+    }
+    return entries;
+}
+
+// Resets a cached statement when it goes out of scope so it can be reused
+// and does not keep a read transaction open between calls.
+class StatementScope {
+public:
+    explicit StatementScope(sqlite3_stmt* stmt) : m_stmt(stmt) {}
+    ~StatementScope() {
+        sqlite3_reset(m_stmt);
+        sqlite3_clear_bindings(m_stmt);
+    }
+    StatementScope(const StatementScope&) = delete;
+    StatementScope& operator=(const StatementScope&) = delete;
+    operator sqlite3_stmt*() const { return m_stmt; }
+private:
+    sqlite3_stmt* m_stmt;
+};
+
+Database::Database() : m_db(nullptr), m_hasSearchIndex(false), m_transactionDepth(0), m_stmtCacheHits(0), m_stmtCacheMisses(0) {}
 Database::~Database() { close(); }
 
-void Database::open(const std::string& path) {
+void Database::open(const std::string& path, const StorageOptions& options) {
     if (m_db) close();
+    m_options = options;
     int rc = sqlite3_open(path.c_str(), &m_db);
     if (rc != SQLITE_OK) {
         std::string errMsg = sqlite3_errmsg(m_db);
@@ -27,14 +92,135 @@ void Database::open(const std::string& path) {
         m_db = nullptr;
         throw DBException("Cannot open database: " + errMsg);
     }
+    m_hasSearchIndex = false;
+    // Wait for locks held by the other process (desktop app / vault-service)
+    // instead of failing immediately with SQLITE_BUSY
+    sqlite3_busy_timeout(m_db, m_options.busyTimeoutMs);
     exec("PRAGMA foreign_keys = ON;");
+
+    if (m_options.walMode) {
+        // WAL lets readers proceed while a writer is active. It is not available
+        // on every filesystem, in which case SQLite keeps the rollback journal.
+        exec("PRAGMA journal_mode = WAL;");
+        if (getJournalMode() == "wal") {
+            exec("PRAGMA synchronous = NORMAL;");
+            exec("PRAGMA wal_autocheckpoint = " + std::to_string(m_options.walAutoCheckpointPages) + ";");
+        }
+    }
+    m_hasSearchIndex = tableExists("entries_fts");
 }
 
 void Database::close() {
+    if (m_db && m_options.walMode) {
+        // Fold what we can of the WAL back into the main file without waiting on readers
+        sqlite3_wal_checkpoint_v2(m_db, nullptr, SQLITE_CHECKPOINT_PASSIVE, nullptr, nullptr);
+    }
+    for (auto& [sql, stmt] : m_stmtCache) {
+        sqlite3_finalize(stmt);
+    }
+    m_stmtCache.clear();
+    m_stmtCacheHits = 0;
+    m_stmtCacheMisses = 0;
     if (m_db) { sqlite3_close(m_db); m_db = nullptr; }
 }
 
+sqlite3_stmt* Database::prepare(const std::string& sql) {
+    auto it = m_stmtCache.find(sql);
+    if (it != m_stmtCache.end()) {
+        ++m_stmtCacheHits;
+        return it->second;
+    }
+    sqlite3_stmt* stmt = nullptr;
+    int rc = sqlite3_prepare_v3(m_db, sql.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &stmt, 0);
+    check_sqlite(rc, m_db);
+    ++m_stmtCacheMisses;
+    m_stmtCache.emplace(sql, stmt);
+    return stmt;
+}
+
+long long Database::getDataVersion() {
+    StatementScope stmt(prepare("PRAGMA data_version;"));
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        throw DBException("Failed to read data version");
+    }
+    return sqlite3_column_int64(stmt, 0);
+}
+
+std::string Database::getJournalMode() {
+    StatementScope stmt(prepare("PRAGMA journal_mode;"));
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        throw DBException("Failed to read journal mode");
+    }
+    return column_string(stmt, 0);
+}
+
+bool Database::checkpoint(bool truncate) {
+    if (!m_db) return false;
+    int rc = sqlite3_wal_checkpoint_v2(m_db, nullptr, truncate ? SQLITE_CHECKPOINT_TRUNCATE : SQLITE_CHECKPOINT_PASSIVE, nullptr, nullptr);
+    return rc == SQLITE_OK;
+}
+
+StatementCacheStats Database::getStatementCacheStats() const {
+    StatementCacheStats stats;
+    stats.hits = m_stmtCacheHits;
+    stats.misses = m_stmtCacheMisses;
+    stats.cachedStatements = m_stmtCache.size();
+    return stats;
+}
+
+// --- SCHEMA MIGRATIONS ---
 void Database::createTables() {
+    // Each step upgrades the schema from (version - 1) to 'version'. To change the
+    // schema, add a migrateToVn() member, append it here and bump SCHEMA_VERSION.
+    struct Migration {
+        int version;
+        void (Database::*apply)();
+    };
+    static const Migration kMigrations[] = {
+        { 1, &Database::migrateToV1 },
+        { 2, &Database::migrateToV2 },
+        { 3, &Database::migrateToV3 },
+        { 4, &Database::migrateToV4 },
+    };
+
+    Transaction txn(*this);
+    int version = getSchemaVersion();
+    if (version > SCHEMA_VERSION) {
+        throw DBException("Vault schema version " + std::to_string(version) + " is newer than supported version " + std::to_string(SCHEMA_VERSION));
+    }
+    for (const Migration& m : kMigrations) {
+        if (m.version <= version) continue;
+        (this->*m.apply)();
+        exec("PRAGMA user_version = " + std::to_string(m.version) + ";");
+    }
+    txn.commit();
+    m_hasSearchIndex = tableExists("entries_fts");
+}
+
+int Database::getSchemaVersion() {
+    StatementScope stmt(prepare("PRAGMA user_version;"));
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        throw DBException("Failed to read schema version");
+    }
+    return sqlite3_column_int(stmt, 0);
+}
+
+bool Database::tableExists(const std::string& table) {
+    StatementScope stmt(prepare("SELECT 1 FROM sqlite_master WHERE name = ?;"));
+    sqlite3_bind_text(stmt, 1, table.c_str(), -1, SQLITE_STATIC);
+    return sqlite3_step(stmt) == SQLITE_ROW;
+}
+
+bool Database::columnExists(const std::string& table, const std::string& column) {
+    StatementScope stmt(prepare("SELECT 1 FROM pragma_table_info(?) WHERE name = ?;"));
+    sqlite3_bind_text(stmt, 1, table.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, column.c_str(), -1, SQLITE_STATIC);
+    return sqlite3_step(stmt) == SQLITE_ROW;
+}
+
+// v1: the original table set. Vaults created before versioning report
+// user_version 0 and already have these tables, so everything is IF NOT EXISTS.
+void Database::migrateToV1() {
     exec(R"( CREATE TABLE IF NOT EXISTS vault_metadata ( key TEXT PRIMARY KEY, value BLOB NOT NULL ); )");
     exec(R"( CREATE TABLE IF NOT EXISTS groups ( id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT UNIQUE NOT NULL, owner_id TEXT DEFAULT 'me' ); )");
     exec(R"( CREATE TABLE IF NOT EXISTS group_keys ( group_id INTEGER PRIMARY KEY, encrypted_group_key BLOB NOT NULL, FOREIGN KEY(group_id) REFERENCES groups(id) ON DELETE CASCADE ); )");
@@ -83,266 +269,496 @@ void Database::createTables() {
 
     exec(R"( CREATE TABLE IF NOT EXISTS group_members ( id INTEGER PRIMARY KEY AUTOINCREMENT, group_id INTEGER NOT NULL, user_id TEXT NOT NULL, role TEXT DEFAULT 'member', status TEXT DEFAULT 'accepted', FOREIGN KEY(group_id) REFERENCES groups(id) ON DELETE CASCADE, UNIQUE(group_id, user_id) ); )");
     exec(R"( CREATE TABLE IF NOT EXISTS group_settings ( group_id INTEGER PRIMARY KEY, admins_only_write INTEGER DEFAULT 0, FOREIGN KEY(group_id) REFERENCES groups(id) ON DELETE CASCADE ); )");
+
+    // Very old vaults predate the invite status column
+    if (!columnExists("pending_invites", "status")) {
+        exec("ALTER TABLE pending_invites ADD COLUMN status TEXT DEFAULT 'pending';");
+    }
+}
+
+// v2: secondary indexes for the lookups that used to be full table scans.
+// group_members(group_id) is already served by its UNIQUE(group_id, user_id) index.
+void Database::migrateToV2() {
+    exec("CREATE INDEX IF NOT EXISTS idx_entries_group_title ON entries(group_id, title);");
+    exec("CREATE INDEX IF NOT EXISTS idx_locations_entry ON locations(entry_id);");
+    exec("CREATE INDEX IF NOT EXISTS idx_locations_value ON locations(value);");
+    exec("CREATE INDEX IF NOT EXISTS idx_password_history_entry ON password_history(entry_id, changed_at);");
+}
+
+// v3: FTS5 trigram index over title, username, notes and location values,
+// keyed by entry id and kept current by triggers. SQLite builds without FTS5
+// or the trigram tokenizer (< 3.34) skip it and searchEntries() falls back to LIKE.
+void Database::migrateToV3() {
+    if (sqlite3_libversion_number() < 3034000 || !sqlite3_compileoption_used("ENABLE_FTS5")) {
+        return;
+    }
+    exec("CREATE VIRTUAL TABLE IF NOT EXISTS entries_fts USING fts5(title, username, notes, locations, tokenize = 'trigram');");
+
+    exec(R"(
+        CREATE TRIGGER IF NOT EXISTS entries_fts_insert AFTER INSERT ON entries BEGIN
+            INSERT INTO entries_fts (rowid, title, username, notes, locations) VALUES (NEW.id, NEW.title, NEW.username, NEW.notes, '');
+        END;
+    )");
+    exec(R"(
+        CREATE TRIGGER IF NOT EXISTS entries_fts_update AFTER UPDATE OF title, username, notes ON entries BEGIN
+            UPDATE entries_fts SET title = NEW.title, username = NEW.username, notes = NEW.notes WHERE rowid = NEW.id;
+        END;
+    )");
+    exec(R"(
+        CREATE TRIGGER IF NOT EXISTS entries_fts_delete AFTER DELETE ON entries BEGIN
+            DELETE FROM entries_fts WHERE rowid = OLD.id;
+        END;
+    )");
+    // Location values are folded into one column per entry
+    exec(R"(
+        CREATE TRIGGER IF NOT EXISTS locations_fts_insert AFTER INSERT ON locations BEGIN
+            UPDATE entries_fts SET locations = (SELECT group_concat(value, ' ') FROM locations WHERE entry_id = NEW.entry_id) WHERE rowid = NEW.entry_id;
+        END;
+    )");
+    exec(R"(
+        CREATE TRIGGER IF NOT EXISTS locations_fts_delete AFTER DELETE ON locations BEGIN
+            UPDATE entries_fts SET locations = coalesce((SELECT group_concat(value, ' ') FROM locations WHERE entry_id = OLD.entry_id), '') WHERE rowid = OLD.entry_id;
+        END;
+    )");
+    exec(R"(
+        CREATE TRIGGER IF NOT EXISTS locations_fts_update AFTER UPDATE OF value ON locations BEGIN
+            UPDATE entries_fts SET locations = (SELECT group_concat(value, ' ') FROM locations WHERE entry_id = NEW.entry_id) WHERE rowid = NEW.entry_id;
+        END;
+    )");
+
+    exec(R"(
+        INSERT INTO entries_fts (rowid, title, username, notes, locations)
+        SELECT e.id, e.title, e.username, e.notes, coalesce((SELECT group_concat(value, ' ') FROM locations WHERE entry_id = e.id), '')
+        FROM entries e;
+    )");
+}
+
+// v4: reversed-host key for web locations (see UrlMatcher) so that
+// findEntriesByLocation() is an index range scan instead of a LIKE scan.
+void Database::migrateToV4() {
+    if (!columnExists("locations", "host_key")) {
+        exec("ALTER TABLE locations ADD COLUMN host_key TEXT;");
+    }
+    exec("CREATE INDEX IF NOT EXISTS idx_locations_host_key ON locations(host_key);");
+
+    std::vector<std::pair<int, std::string>> keys;
+    {
+        StatementScope stmt(prepare("SELECT id, type, value FROM locations;"));
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            std::string hostKey = UrlMatcher::hostKeyForLocation(column_string(stmt, 1), column_string(stmt, 2));
+            if (!hostKey.empty()) keys.emplace_back(sqlite3_column_int(stmt, 0), std::move(hostKey));
+        }
+    }
+    StatementScope update(prepare("UPDATE locations SET host_key = ? WHERE id = ?;"));
+    for (const auto& [id, hostKey] : keys) {
+        sqlite3_bind_text(update, 1, hostKey.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(update, 2, id);
+        if (sqlite3_step(update) != SQLITE_DONE) { throw DBException("Failed to backfill host key: " + std::string(sqlite3_errmsg(m_db))); }
+        sqlite3_reset(update);
+    }
 }
 
 void Database::exec(const std::string& sql) {
     char* zErrMsg = nullptr;
     int rc = sqlite3_exec(m_db, sql.c_str(), 0, 0, &zErrMsg);
+    // The busy timeout already waited; back off and retry a few more times
+    // before giving up on a lock held by another process
+    for (int attempt = 0; rc == SQLITE_BUSY && attempt < m_options.busyRetries; ++attempt) {
+        sqlite3_free(zErrMsg);
+        zErrMsg = nullptr;
+        std::this_thread::sleep_for(std::chrono::milliseconds(m_options.busyRetryDelayMs * (attempt + 1)));
+        rc = sqlite3_exec(m_db, sql.c_str(), 0, 0, &zErrMsg);
+    }
     if (rc != SQLITE_OK) {
-        std::string errMsg = zErrMsg;
+        std::string errMsg = zErrMsg ? zErrMsg : sqlite3_errmsg(m_db);
         sqlite3_free(zErrMsg);
         throw DBException("SQL error: " + errMsg);
     }
 }
 
+Transaction::Transaction(Database& db) : m_db(db), m_depth(db.m_transactionDepth + 1), m_open(false) {
+    m_db.exec(m_depth == 1 ? std::string("BEGIN IMMEDIATE;") : "SAVEPOINT " + savepointName() + ";");
+    m_db.m_transactionDepth = m_depth;
+    m_open = true;
+}
+
+Transaction::~Transaction() {
+    if (!m_open) return;
+    try {
+        // A savepoint stays on the stack after ROLLBACK TO; release it too
+        m_db.exec(m_depth == 1 ? std::string("ROLLBACK;")
+                               : "ROLLBACK TO " + savepointName() + "; RELEASE " + savepointName() + ";");
+    } catch (...) {
+        // SQLite may already have rolled back on its own (e.g. disk full)
+    }
+    close();
+}
+
+void Transaction::commit() {
+    if (!m_open) {
+        throw DBException("Transaction already finished");
+    }
+    // A failed COMMIT leaves the transaction open; the destructor rolls it back
+    m_db.exec(m_depth == 1 ? std::string("COMMIT;") : "RELEASE " + savepointName() + ";");
+    close();
+}
+
+std::string Transaction::savepointName() const {
+    return "txn_" + std::to_string(m_depth);
+}
+
+void Transaction::close() {
+    m_open = false;
+    m_db.m_transactionDepth = m_depth - 1;
+}
+
 // --- METADATA & GROUPS (Unchanged) ---
 void Database::storeMetadata(const std::string& key, const std::vector<unsigned char>& value) {
-    sqlite3_stmt* stmt;
     const char* sql = "INSERT OR REPLACE INTO vault_metadata (key, value) VALUES (?, ?);";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_blob(stmt, 2, value.data(), value.size(), SQLITE_STATIC);
-    sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    if (sqlite3_step(stmt) != SQLITE_DONE) { throw DBException("Failed to store metadata: " + std::string(sqlite3_errmsg(m_db))); }
 }
 
 std::vector<unsigned char> Database::getMetadata(const std::string& key) {
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT value FROM vault_metadata WHERE key = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         const void* blob = sqlite3_column_blob(stmt, 0);
         int size = sqlite3_column_bytes(stmt, 0);
         std::vector<unsigned char> value(static_cast<const unsigned char*>(blob), static_cast<const unsigned char*>(blob) + size);
-        sqlite3_finalize(stmt);
         return value;
     }
-    sqlite3_finalize(stmt);
     throw DBException("Metadata key not found: " + key);
 }
 
 void Database::storeEncryptedGroup(const std::string& name, const std::vector<unsigned char>& encryptedKey, const std::string& ownerId) {
-    exec("BEGIN TRANSACTION;");
-    try {
-        sqlite3_stmt* stmt1;
-        const char* sql1 = "INSERT INTO groups (name, owner_id) VALUES (?, ?);";
-        int rc = sqlite3_prepare_v2(m_db, sql1, -1, &stmt1, 0);
-        check_sqlite(rc, m_db);
-        sqlite3_bind_text(stmt1, 1, name.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt1, 2, ownerId.c_str(), -1, SQLITE_STATIC);
-        if (sqlite3_step(stmt1) != SQLITE_DONE) { sqlite3_finalize(stmt1); throw DBException("Failed to insert group name"); }
-        sqlite3_finalize(stmt1);
-        sqlite3_int64 groupId = sqlite3_last_insert_rowid(m_db);
-        sqlite3_stmt* stmt2;
-        const char* sql2 = "INSERT INTO group_keys (group_id, encrypted_group_key) VALUES (?, ?);";
-        rc = sqlite3_prepare_v2(m_db, sql2, -1, &stmt2, 0);
-        check_sqlite(rc, m_db);
-        sqlite3_bind_int64(stmt2, 1, groupId);
-        sqlite3_bind_blob(stmt2, 2, encryptedKey.data(), encryptedKey.size(), SQLITE_STATIC);
-        if (sqlite3_step(stmt2) != SQLITE_DONE) { sqlite3_finalize(stmt2); throw DBException("Failed to insert group key"); }
-        sqlite3_finalize(stmt2);
-        exec("INSERT INTO group_settings (group_id, admins_only_write) VALUES (" + std::to_string(groupId) + ", 0);");
-        exec("COMMIT;");
-    } catch (...) { exec("ROLLBACK;"); throw; }
+    Transaction txn(*this);
+    const char* sql1 = "INSERT INTO groups (name, owner_id) VALUES (?, ?);";
+    StatementScope stmt1(prepare(sql1));
+    sqlite3_bind_text(stmt1, 1, name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt1, 2, ownerId.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt1) != SQLITE_DONE) { throw DBException("Failed to insert group name"); }
+    sqlite3_int64 groupId = sqlite3_last_insert_rowid(m_db);
+    const char* sql2 = "INSERT INTO group_keys (group_id, encrypted_group_key) VALUES (?, ?);";
+    StatementScope stmt2(prepare(sql2));
+    sqlite3_bind_int64(stmt2, 1, groupId);
+    sqlite3_bind_blob(stmt2, 2, encryptedKey.data(), encryptedKey.size(), SQLITE_STATIC);
+    if (sqlite3_step(stmt2) != SQLITE_DONE) { throw DBException("Failed to insert group key"); }
+    const char* sql3 = "INSERT INTO group_settings (group_id, admins_only_write) VALUES (?, 0);";
+    StatementScope stmt3(prepare(sql3));
+    sqlite3_bind_int64(stmt3, 1, groupId);
+    if (sqlite3_step(stmt3) != SQLITE_DONE) { throw DBException("Failed to insert group settings"); }
+    txn.commit();
 }
 
 std::vector<unsigned char> Database::getEncryptedGroupKey(const std::string& name, int& groupId) {
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT g.id, gk.encrypted_group_key FROM groups g JOIN group_keys gk ON g.id = gk.group_id WHERE g.name = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         groupId = sqlite3_column_int(stmt, 0);
         const void* blob = sqlite3_column_blob(stmt, 1);
         int size = sqlite3_column_bytes(stmt, 1);
         std::vector<unsigned char> value(static_cast<const unsigned char*>(blob), static_cast<const unsigned char*>(blob) + size);
-        sqlite3_finalize(stmt);
         return value;
     }
-    sqlite3_finalize(stmt);
     throw DBException("Group not found: " + name);
 }
 
 std::vector<unsigned char> Database::getEncryptedGroupKeyById(int groupId) {
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT encrypted_group_key FROM group_keys WHERE group_id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, groupId);
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         const void* blob = sqlite3_column_blob(stmt, 0);
         int size = sqlite3_column_bytes(stmt, 0);
         std::vector<unsigned char> value(static_cast<const unsigned char*>(blob), static_cast<const unsigned char*>(blob) + size);
-        sqlite3_finalize(stmt);
         return value;
     }
-    sqlite3_finalize(stmt);
     throw DBException("Group key not found for ID");
 }
 
 std::map<int, std::vector<unsigned char>> Database::getAllEncryptedGroupKeys() {
     std::map<int, std::vector<unsigned char>> keys;
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT group_id, encrypted_group_key FROM group_keys;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         int groupId = sqlite3_column_int(stmt, 0);
         const void* blob = sqlite3_column_blob(stmt, 1);
         int size = sqlite3_column_bytes(stmt, 1);
         keys[groupId] = std::vector<unsigned char>(static_cast<const unsigned char*>(blob), static_cast<const unsigned char*>(blob) + size);
     }
-    sqlite3_finalize(stmt);
     return keys;
 }
 
 void Database::updateEncryptedGroupKey(int groupId, const std::vector<unsigned char>& newKey) {
-    sqlite3_stmt* stmt;
     const char* sql = "UPDATE group_keys SET encrypted_group_key = ? WHERE group_id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_blob(stmt, 1, newKey.data(), newKey.size(), SQLITE_STATIC);
     sqlite3_bind_int(stmt, 2, groupId);
-    sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    if (sqlite3_step(stmt) != SQLITE_DONE) { throw DBException("Failed to update group key: " + std::string(sqlite3_errmsg(m_db))); }
+}
+
+void Database::replaceKeyMaterial(const std::map<int, std::vector<unsigned char>>& encryptedGroupKeys,
+                                  const std::map<std::string, std::vector<unsigned char>>& metadata) {
+    Transaction txn(*this);
+    for (const auto& [groupId, encryptedKey] : encryptedGroupKeys) {
+        updateEncryptedGroupKey(groupId, encryptedKey);
+    }
+    for (const auto& [key, value] : metadata) {
+        storeMetadata(key, value);
+    }
+    txn.commit();
 }
 
 std::vector<std::string> Database::getAllGroupNames() {
     std::vector<std::string> names;
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT name FROM groups ORDER BY name;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         const unsigned char* name = sqlite3_column_text(stmt, 0);
         names.push_back(std::string(reinterpret_cast<const char*>(name)));
     }
-    sqlite3_finalize(stmt);
     return names;
 }
 
 int Database::getGroupId(const std::string& name) {
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT id FROM groups WHERE name = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         int id = sqlite3_column_int(stmt, 0);
-        sqlite3_finalize(stmt);
         return id;
     }
-    sqlite3_finalize(stmt);
     throw DBException("Group not found: " + name);
 }
 
 int Database::getGroupIdForEntry(int entryId) {
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT group_id FROM entries WHERE id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, entryId);
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         int id = sqlite3_column_int(stmt, 0);
-        sqlite3_finalize(stmt);
         return id;
     }
-    sqlite3_finalize(stmt);
     throw DBException("Entry not found");
 }
 
 bool Database::deleteGroup(const std::string& name) {
-    sqlite3_stmt* stmt;
     const char* sql = "DELETE FROM groups WHERE name = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    sqlite3_step(stmt);
     return sqlite3_changes(m_db) > 0;
 }
 
 // --- ENTRIES ---
 void Database::storeEntry(int groupId, VaultEntry& entry, const std::vector<unsigned char>& encryptedPassword) {
-    exec("BEGIN TRANSACTION;");
-    try {
-        sqlite3_stmt* stmt;
-        long long now = std::time(nullptr);
-        const char* sql = "INSERT INTO entries (group_id, title, username, notes, encrypted_password, created_at, last_modified, last_accessed, password_expiry) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);";
-        int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-        check_sqlite(rc, m_db);
-        sqlite3_bind_int(stmt, 1, groupId);
-        sqlite3_bind_text(stmt, 2, entry.title.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, entry.username.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 4, entry.notes.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_blob(stmt, 5, encryptedPassword.data(), encryptedPassword.size(), SQLITE_STATIC);
-        sqlite3_bind_int64(stmt, 6, now); // created_at
-        sqlite3_bind_int64(stmt, 7, now); // last_modified
-        sqlite3_bind_int64(stmt, 8, now); // last_accessed
-        sqlite3_bind_int64(stmt, 9, entry.passwordExpiry); // password_expiry
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
-        entry.id = sqlite3_last_insert_rowid(m_db);
-        entry.createdAt = now;
-        entry.lastModified = now;
-        entry.lastAccessed = now;
-        
-        sqlite3_stmt* loc_stmt;
-        const char* loc_sql = "INSERT INTO locations (entry_id, type, value) VALUES (?, ?, ?);";
-        rc = sqlite3_prepare_v2(m_db, loc_sql, -1, &loc_stmt, 0);
-        check_sqlite(rc, m_db);
-        for (Location& loc : entry.locations) {
-            sqlite3_bind_int(loc_stmt, 1, entry.id);
-            sqlite3_bind_text(loc_stmt, 2, loc.type.c_str(), -1, SQLITE_STATIC);
-            sqlite3_bind_text(loc_stmt, 3, loc.value.c_str(), -1, SQLITE_STATIC);
-            sqlite3_step(loc_stmt);
-            loc.id = sqlite3_last_insert_rowid(m_db); 
-            sqlite3_reset(loc_stmt);
-        }
-        sqlite3_finalize(loc_stmt);
-        exec("COMMIT;");
-    } catch (...) { exec("ROLLBACK;"); throw; }
+    Transaction txn(*this);
+    insertEntry(groupId, entry, encryptedPassword, std::time(nullptr));
+    txn.commit();
+}
+
+void Database::storeEntries(int groupId, std::vector<VaultEntry>& entries, const std::vector<std::vector<unsigned char>>& encryptedPasswords) {
+    if (entries.size() != encryptedPasswords.size()) {
+        throw DBException("storeEntries: entry and password counts differ");
+    }
+    Transaction txn(*this);
+    long long now = std::time(nullptr);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        insertEntry(groupId, entries[i], encryptedPasswords[i], now);
+    }
+    txn.commit();
+}
+
+// Inserts one entry and its locations; the caller owns the transaction
+void Database::insertEntry(int groupId, VaultEntry& entry, const std::vector<unsigned char>& encryptedPassword, long long now) {
+    const char* sql = "INSERT INTO entries (group_id, title, username, notes, encrypted_password, created_at, last_modified, last_accessed, password_expiry) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);";
+    StatementScope stmt(prepare(sql));
+    sqlite3_bind_int(stmt, 1, groupId);
+    sqlite3_bind_text(stmt, 2, entry.title.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, entry.username.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, entry.notes.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_blob(stmt, 5, encryptedPassword.data(), encryptedPassword.size(), SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 6, now); // created_at
+    sqlite3_bind_int64(stmt, 7, now); // last_modified
+    sqlite3_bind_int64(stmt, 8, now); // last_accessed
+    sqlite3_bind_int64(stmt, 9, entry.passwordExpiry); // password_expiry
+    if (sqlite3_step(stmt) != SQLITE_DONE) { throw DBException("Failed to insert entry: " + std::string(sqlite3_errmsg(m_db))); }
+    entry.id = sqlite3_last_insert_rowid(m_db);
+    entry.createdAt = now;
+    entry.lastModified = now;
+    entry.lastAccessed = now;
+    
+    const char* loc_sql = "INSERT INTO locations (entry_id, type, value, host_key) VALUES (?, ?, ?, ?);";
+    StatementScope loc_stmt(prepare(loc_sql));
+    for (Location& loc : entry.locations) {
+        std::string hostKey = UrlMatcher::hostKeyForLocation(loc.type, loc.value);
+        sqlite3_bind_int(loc_stmt, 1, entry.id);
+        sqlite3_bind_text(loc_stmt, 2, loc.type.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(loc_stmt, 3, loc.value.c_str(), -1, SQLITE_STATIC);
+        bind_optional_text(loc_stmt, 4, hostKey);
+        if (sqlite3_step(loc_stmt) != SQLITE_DONE) { throw DBException("Failed to insert location: " + std::string(sqlite3_errmsg(m_db))); }
+        loc.id = sqlite3_last_insert_rowid(m_db); 
+        sqlite3_reset(loc_stmt);
+    }
 }
 
 std::vector<VaultEntry> Database::getEntriesForGroup(int groupId) {
-    std::vector<VaultEntry> entries;
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id, title, username, notes, created_at, last_modified, last_accessed, password_expiry FROM entries WHERE group_id = ? ORDER BY title;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    const char* sql = R"(
+        SELECT e.id, e.title, e.username, e.notes, e.created_at, e.last_modified, e.last_accessed, e.password_expiry,
+               l.id, l.type, l.value
+        FROM entries e
+        LEFT JOIN locations l ON l.entry_id = e.id
+        WHERE e.group_id = ?
+        ORDER BY e.title, e.id, l.id;
+    )";
+    StatementScope stmt(prepare(sql));
+    sqlite3_bind_int(stmt, 1, groupId);
+    return readEntriesWithLocations(stmt);
+}
+
+EntryPage Database::getEntriesForGroupPage(int groupId, int limit, const std::string& pageToken) {
+    std::string afterTitle;
+    int afterId = 0;
+    decodePageRequest(limit, pageToken, afterTitle, afterId);
+    // The row-value comparison is a range on (group_id, title, rowid); the
+    // outer ORDER BY only sorts one page
+    const char* sql = R"(
+        SELECT e.id, e.title, e.username, e.notes, e.created_at, e.last_modified, e.last_accessed, e.password_expiry,
+               l.id, l.type, l.value
+        FROM (
+            SELECT id, title, username, notes, created_at, last_modified, last_accessed, password_expiry
+            FROM entries
+            WHERE group_id = ? AND (title, id) > (?, ?)
+            ORDER BY title, id
+            LIMIT ?
+        ) e
+        LEFT JOIN locations l ON l.entry_id = e.id
+        ORDER BY e.title, e.id, l.id;
+    )";
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, groupId);
+    sqlite3_bind_text(stmt, 2, afterTitle.data(), static_cast<int>(afterTitle.size()), SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 3, afterId);
+    sqlite3_bind_int(stmt, 4, limit + 1);
+    return makeEntryPage(readEntriesWithLocations(stmt), limit);
+}
+
+// Tokens are "<id>:<hex title>" of the last entry on the page. Clients treat
+// them as opaque; the hex keeps any title safe to pass through JSON.
+void Database::decodePageRequest(int limit, const std::string& pageToken, std::string& afterTitle, int& afterId) {
+    if (limit <= 0 || limit == INT_MAX) {
+        throw DBException("Invalid page size: " + std::to_string(limit));
+    }
+    afterTitle.clear();
+    afterId = 0; // first page: every (title, id) sorts after ("", 0)
+    if (pageToken.empty()) {
+        return;
+    }
+    const std::string hexDigits = "0123456789abcdef";
+    size_t colon = pageToken.find(':');
+    std::string idPart = pageToken.substr(0, colon);
+    std::string titlePart = colon == std::string::npos ? "" : pageToken.substr(colon + 1);
+    bool valid = colon != std::string::npos && !idPart.empty() && idPart.size() <= 10 &&
+                 idPart.find_first_not_of("0123456789") == std::string::npos &&
+                 titlePart.size() % 2 == 0 && titlePart.find_first_not_of(hexDigits) == std::string::npos &&
+                 std::stoll(idPart) <= INT_MAX;
+    if (!valid) {
+        throw DBException("Invalid page token");
+    }
+    afterId = static_cast<int>(std::stoll(idPart));
+    for (size_t i = 0; i < titlePart.size(); i += 2) {
+        afterTitle += static_cast<char>(hexDigits.find(titlePart[i]) * 16 + hexDigits.find(titlePart[i + 1]));
+    }
+}
+
+EntryPage Database::makeEntryPage(std::vector<VaultEntry> entries, int limit) {
+    EntryPage page;
+    page.entries = std::move(entries);
+    if (page.entries.size() > static_cast<size_t>(limit)) {
+        page.entries.resize(limit);
+        const VaultEntry& last = page.entries.back();
+        static const char hexDigits[] = "0123456789abcdef";
+        page.nextPageToken = std::to_string(last.id) + ":";
+        for (unsigned char c : last.title) {
+            page.nextPageToken += hexDigits[c >> 4];
+            page.nextPageToken += hexDigits[c & 0x0f];
+        }
+    }
+    return page;
+}
+
+VaultEntry Database::getEntry(int entryId) {
+    const char* sql = R"(
+        SELECT e.id, e.title, e.username, e.notes, e.created_at, e.last_modified, e.last_accessed, e.password_expiry,
+               l.id, l.type, l.value
+        FROM entries e
+        LEFT JOIN locations l ON l.entry_id = e.id
+        WHERE e.id = ?
+        ORDER BY l.id;
+    )";
+    StatementScope stmt(prepare(sql));
+    sqlite3_bind_int(stmt, 1, entryId);
+    std::vector<VaultEntry> entries = readEntriesWithLocations(stmt);
+    if (entries.empty()) {
+        throw DBException("Entry not found");
+    }
+    return entries.front();
+}
+
+std::vector<int> Database::getEntryIds() {
+    std::vector<int> ids;
+    const char* sql = "SELECT id FROM entries;";
+    StatementScope stmt(prepare(sql));
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        std::string title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        std::string username = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        std::string notes = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        VaultEntry entry(id, title, username, notes);
-        entry.createdAt = sqlite3_column_int64(stmt, 4);
-        entry.lastModified = sqlite3_column_int64(stmt, 5);
-        entry.lastAccessed = sqlite3_column_int64(stmt, 6);
-        entry.passwordExpiry = sqlite3_column_int64(stmt, 7);
-        entry.locations = getLocationsForEntry(id);
-        entries.push_back(std::move(entry));
-    }
-    sqlite3_finalize(stmt);
-    return entries;
+        ids.push_back(sqlite3_column_int(stmt, 0));
+    }
+    return ids;
+}
+
+std::vector<VaultEntry> Database::getEntriesChangedSince(long long modifiedSince, int afterId) {
+    const char* sql = R"(
+        SELECT e.id, e.title, e.username, e.notes, e.created_at, e.last_modified, e.last_accessed, e.password_expiry,
+               l.id, l.type, l.value
+        FROM entries e
+        LEFT JOIN locations l ON l.entry_id = e.id
+        WHERE e.last_modified >= ? OR e.id > ?
+        ORDER BY e.id, l.id;
+    )";
+    StatementScope stmt(prepare(sql));
+    sqlite3_bind_int64(stmt, 1, modifiedSince);
+    sqlite3_bind_int(stmt, 2, afterId);
+    return readEntriesWithLocations(stmt);
+}
+
+std::vector<VaultEntry> Database::getEntriesWithPasswordsForGroup(int groupId, std::vector<std::vector<unsigned char>>& encryptedPasswords) {
+    encryptedPasswords.clear();
+    const char* sql = R"(
+        SELECT e.id, e.title, e.username, e.notes, e.created_at, e.last_modified, e.last_accessed, e.password_expiry,
+               l.id, l.type, l.value, e.encrypted_password
+        FROM entries e
+        LEFT JOIN locations l ON l.entry_id = e.id
+        WHERE e.group_id = ?
+        ORDER BY e.title, e.id, l.id;
+    )";
+    StatementScope stmt(prepare(sql));
+    sqlite3_bind_int(stmt, 1, groupId);
+    return readEntriesWithLocations(stmt, &encryptedPasswords);
 }
 
 std::vector<Location> Database::getLocationsForEntry(int entryId) {
     std::vector<Location> locations;
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT id, type, value FROM locations WHERE entry_id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, entryId);
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         int id = sqlite3_column_int(stmt, 0);
@@ -350,190 +766,297 @@ std::vector<Location> Database::getLocationsForEntry(int entryId) {
         std::string value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
         locations.emplace_back(id, type, value);
     }
-    sqlite3_finalize(stmt);
     return locations;
 }
 
 std::vector<VaultEntry> Database::findEntriesByLocation(const std::string& locationValue) {
-    std::vector<VaultEntry> entries;
-    sqlite3_stmt* stmt;
-    
-    // First try exact match
+    // Exact value matches rank first, then locations on the same host, then
+    // anything else under the same registrable domain (e.g. github.com and
+    // gist.github.com). Site candidates come from a range scan on host_key:
+    // every host under "github.com" has a key starting with "com.github.".
+    UrlMatcher::ParsedUrl url = UrlMatcher::parse(locationValue);
+    std::string hostKey, siteKeyBegin, siteKeyEnd;
+    if (url.valid) {
+        hostKey = UrlMatcher::reversedHostKey(url.host);
+        siteKeyBegin = UrlMatcher::reversedHostKey(url.registrableDomain);
+        siteKeyEnd = siteKeyBegin;
+        siteKeyEnd.back() = '.' + 1;
+    }
+
     const char* sql = R"(
-        SELECT DISTINCT e.id, e.title, e.username, e.notes 
-        FROM entries e 
-        JOIN locations l ON e.id = l.entry_id 
-        WHERE l.value = ?
-        UNION
-        SELECT DISTINCT e.id, e.title, e.username, e.notes 
-        FROM entries e 
-        JOIN locations l ON e.id = l.entry_id 
-        WHERE ? LIKE '%' || l.value || '%' OR l.value LIKE '%' || ? || '%';
+        WITH matches AS (
+            SELECT entry_id AS id, min(rank) AS rank FROM (
+                SELECT entry_id, 0 AS rank FROM locations WHERE value = ?1
+                UNION ALL
+                SELECT entry_id, CASE WHEN host_key = ?2 THEN 1 ELSE 2 END FROM locations
+                WHERE host_key >= ?3 AND host_key < ?4
+            ) GROUP BY entry_id
+        )
+        SELECT e.id, e.title, e.username, e.notes, e.created_at, e.last_modified, e.last_accessed, e.password_expiry,
+               l.id, l.type, l.value
+        FROM matches m
+        JOIN entries e ON e.id = m.id
+        LEFT JOIN locations l ON l.entry_id = e.id
+        ORDER BY m.rank, e.id, l.id;
     )";
     
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_text(stmt, 1, locationValue.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, locationValue.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, locationValue.c_str(), -1, SQLITE_STATIC);
-    
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        std::string title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        std::string username = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        std::string notes = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        VaultEntry entry(id, title, username, notes);
-        entry.locations = getLocationsForEntry(id); 
-        entries.push_back(std::move(entry));
-    }
-    sqlite3_finalize(stmt);
+    bind_optional_text(stmt, 2, hostKey);
+    bind_optional_text(stmt, 3, siteKeyBegin);
+    bind_optional_text(stmt, 4, siteKeyEnd);
+    std::vector<VaultEntry> entries = readEntriesWithLocations(stmt);
+
+    // Same-site candidates that pin a different explicit port are different services
+    if (url.valid && url.port != -1) {
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const VaultEntry& entry) {
+            return std::none_of(entry.locations.begin(), entry.locations.end(), [&](const Location& loc) {
+                return loc.value == locationValue || UrlMatcher::sameSite(UrlMatcher::parse(loc.value), url);
+            });
+        }), entries.end());
+    }
     return entries;
 }
 
 std::vector<VaultEntry> Database::searchEntries(const std::string& searchTerm) {
-    std::vector<VaultEntry> entries;
-    sqlite3_stmt* stmt;
-    const char* sql = R"( SELECT id, title, username, notes FROM entries WHERE title LIKE ? OR username LIKE ? UNION SELECT DISTINCT e.id, e.title, e.username, e.notes FROM entries e JOIN locations l ON e.id = l.entry_id WHERE l.value LIKE ?; )";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    // Trigrams need at least three characters; shorter terms use the LIKE scan
+    size_t codepoints = 0;
+    for (unsigned char c : searchTerm) {
+        if ((c & 0xC0) != 0x80) ++codepoints;
+    }
+    if (!m_hasSearchIndex || codepoints < 3) {
+        return searchEntriesByScan(searchTerm);
+    }
+
+    // Quote the term as a single FTS5 phrase so user input is never parsed as query syntax
+    std::string phrase = "\"";
+    for (char c : searchTerm) {
+        if (c == '"') phrase += '"';
+        phrase += c;
+    }
+    phrase += '"';
+
+    const char* sql = R"(
+        WITH matches AS (
+            SELECT rowid AS id, bm25(entries_fts, 10.0, 5.0, 1.0, 3.0) AS score
+            FROM entries_fts WHERE entries_fts MATCH ?
+        )
+        SELECT e.id, e.title, e.username, e.notes, e.created_at, e.last_modified, e.last_accessed, e.password_expiry,
+               l.id, l.type, l.value
+        FROM matches m
+        JOIN entries e ON e.id = m.id
+        LEFT JOIN locations l ON l.entry_id = e.id
+        ORDER BY m.score, e.id, l.id;
+    )";
+    StatementScope stmt(prepare(sql));
+    sqlite3_bind_text(stmt, 1, phrase.c_str(), -1, SQLITE_STATIC);
+    return readEntriesWithLocations(stmt);
+}
+
+std::vector<VaultEntry> Database::searchEntriesByScan(const std::string& searchTerm) {
+    const char* sql = R"(
+        WITH matches AS (
+            SELECT id FROM entries WHERE title LIKE ? OR username LIKE ?
+            UNION
+            SELECT entry_id FROM locations WHERE value LIKE ?
+        )
+        SELECT e.id, e.title, e.username, e.notes, e.created_at, e.last_modified, e.last_accessed, e.password_expiry,
+               l.id, l.type, l.value
+        FROM matches m
+        JOIN entries e ON e.id = m.id
+        LEFT JOIN locations l ON l.entry_id = e.id
+        ORDER BY e.id, l.id;
+    )";
+    StatementScope stmt(prepare(sql));
     std::string likeTerm = "%" + searchTerm + "%";
     sqlite3_bind_text(stmt, 1, likeTerm.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 2, likeTerm.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 3, likeTerm.c_str(), -1, SQLITE_STATIC);
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        std::string title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        std::string username = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        std::string notes = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        VaultEntry entry(id, title, username, notes);
-        entry.locations = getLocationsForEntry(id);
-        entries.push_back(std::move(entry));
-    }
-    sqlite3_finalize(stmt);
-    return entries;
+    return readEntriesWithLocations(stmt);
 }
 
 std::vector<unsigned char> Database::getEncryptedPassword(int entryId) {
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT encrypted_password FROM entries WHERE id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, entryId);
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         const void* blob = sqlite3_column_blob(stmt, 0);
         int size = sqlite3_column_bytes(stmt, 0);
         std::vector<unsigned char> value(static_cast<const unsigned char*>(blob), static_cast<const unsigned char*>(blob) + size);
-        sqlite3_finalize(stmt);
         return value;
     }
-    sqlite3_finalize(stmt);
     throw DBException("Entry not found");
 }
 
+std::vector<unsigned char> Database::getEncryptedPassword(int entryId, int& groupId) {
+    const char* sql = "SELECT encrypted_password, group_id FROM entries WHERE id = ?;";
+    StatementScope stmt(prepare(sql));
+    sqlite3_bind_int(stmt, 1, entryId);
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        const void* blob = sqlite3_column_blob(stmt, 0);
+        int size = sqlite3_column_bytes(stmt, 0);
+        groupId = sqlite3_column_int(stmt, 1);
+        return std::vector<unsigned char>(static_cast<const unsigned char*>(blob), static_cast<const unsigned char*>(blob) + size);
+    }
+    throw DBException("Entry not found");
+}
+
+// Reads (id, blob) rows from a statement whose first two columns are those
+static std::vector<EncryptedPasswordRow> readEncryptedPasswordRows(sqlite3_stmt* stmt) {
+    std::vector<EncryptedPasswordRow> rows;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char* blob = static_cast<const unsigned char*>(sqlite3_column_blob(stmt, 1));
+        int size = sqlite3_column_bytes(stmt, 1);
+        rows.push_back({ sqlite3_column_int(stmt, 0), std::vector<unsigned char>(blob, blob + size) });
+    }
+    return rows;
+}
+
+std::vector<EncryptedPasswordRow> Database::getEncryptedPasswordsForGroup(int groupId) {
+    const char* sql = "SELECT id, encrypted_password FROM entries WHERE group_id = ?;";
+    StatementScope stmt(prepare(sql));
+    sqlite3_bind_int(stmt, 1, groupId);
+    return readEncryptedPasswordRows(stmt);
+}
+
+std::vector<EncryptedPasswordRow> Database::getEncryptedPasswordHistoryForGroup(int groupId) {
+    const char* sql = R"(
+        SELECT h.id, h.encrypted_password FROM password_history h
+        JOIN entries e ON e.id = h.entry_id
+        WHERE e.group_id = ?;
+    )";
+    StatementScope stmt(prepare(sql));
+    sqlite3_bind_int(stmt, 1, groupId);
+    return readEncryptedPasswordRows(stmt);
+}
+
+void Database::updateEncryptedPasswords(const std::vector<EncryptedPasswordRow>& rows) {
+    Transaction txn(*this);
+    const char* sql = "UPDATE entries SET encrypted_password = ? WHERE id = ?;";
+    StatementScope stmt(prepare(sql));
+    for (const EncryptedPasswordRow& row : rows) {
+        sqlite3_bind_blob(stmt, 1, row.encryptedPassword.data(), row.encryptedPassword.size(), SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 2, row.id);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            throw DBException("Failed to update password: " + std::string(sqlite3_errmsg(m_db)));
+        }
+        sqlite3_reset(stmt);
+    }
+    txn.commit();
+}
+
+void Database::updateEncryptedPasswordHistory(const std::vector<EncryptedPasswordRow>& rows) {
+    Transaction txn(*this);
+    const char* sql = "UPDATE password_history SET encrypted_password = ? WHERE id = ?;";
+    StatementScope stmt(prepare(sql));
+    for (const EncryptedPasswordRow& row : rows) {
+        sqlite3_bind_blob(stmt, 1, row.encryptedPassword.data(), row.encryptedPassword.size(), SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 2, row.id);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            throw DBException("Failed to update password history: " + std::string(sqlite3_errmsg(m_db)));
+        }
+        sqlite3_reset(stmt);
+    }
+    txn.commit();
+}
+
 bool Database::deleteEntry(int entryId) {
-    sqlite3_stmt* stmt;
     const char* sql = "DELETE FROM entries WHERE id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, entryId);
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    sqlite3_step(stmt);
     return sqlite3_changes(m_db) > 0;
 }
 
 void Database::updateEntry(const VaultEntry& entry, const std::vector<unsigned char>* newEncryptedPassword) {
-    exec("BEGIN TRANSACTION;");
-    try {
-        sqlite3_stmt* stmt;
-        const char* sql = "UPDATE entries SET title = ?, username = ?, notes = ?, last_modified = ?, password_expiry = ? WHERE id = ?;";
-        int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-        check_sqlite(rc, m_db);
-        sqlite3_bind_text(stmt, 1, entry.title.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, entry.username.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, entry.notes.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_int64(stmt, 4, std::time(nullptr));
-        sqlite3_bind_int64(stmt, 5, entry.passwordExpiry);
-        sqlite3_bind_int(stmt, 6, entry.id);
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+    Transaction txn(*this);
+    const char* sql = "UPDATE entries SET title = ?, username = ?, notes = ?, last_modified = ?, password_expiry = ? WHERE id = ?;";
+    StatementScope stmt(prepare(sql));
+    sqlite3_bind_text(stmt, 1, entry.title.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, entry.username.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, entry.notes.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 4, std::time(nullptr));
+    sqlite3_bind_int64(stmt, 5, entry.passwordExpiry);
+    sqlite3_bind_int(stmt, 6, entry.id);
+    sqlite3_step(stmt);
 
-        if (newEncryptedPassword) {
-            // Save old password to history first
-            try {
-                std::vector<unsigned char> oldPassword = getEncryptedPassword(entry.id);
-                storePasswordHistory(entry.id, oldPassword);
-                // Keep only last 10 passwords
-                deleteOldPasswordHistory(entry.id, 10);
-            } catch (...) {
-                // If entry doesn't exist or error, continue with password update
-            }
-            
-            sqlite3_stmt* pass_stmt;
-            const char* pass_sql = "UPDATE entries SET encrypted_password = ? WHERE id = ?;";
-            rc = sqlite3_prepare_v2(m_db, pass_sql, -1, &pass_stmt, 0);
-            check_sqlite(rc, m_db);
-            sqlite3_bind_blob(pass_stmt, 1, newEncryptedPassword->data(), newEncryptedPassword->size(), SQLITE_STATIC);
-            sqlite3_bind_int(pass_stmt, 2, entry.id);
-            sqlite3_step(pass_stmt);
-            sqlite3_finalize(pass_stmt);
+    if (newEncryptedPassword) {
+        // Save old password to history first
+        try {
+            std::vector<unsigned char> oldPassword = getEncryptedPassword(entry.id);
+            storePasswordHistory(entry.id, oldPassword);
+            // Keep only last 10 passwords
+            deleteOldPasswordHistory(entry.id, 10);
+        } catch (...) {
+            // If entry doesn't exist or error, continue with password update
         }
+        
+        const char* pass_sql = "UPDATE entries SET encrypted_password = ? WHERE id = ?;";
+        StatementScope pass_stmt(prepare(pass_sql));
+        sqlite3_bind_blob(pass_stmt, 1, newEncryptedPassword->data(), newEncryptedPassword->size(), SQLITE_STATIC);
+        sqlite3_bind_int(pass_stmt, 2, entry.id);
+        sqlite3_step(pass_stmt);
+    }
 
-        sqlite3_stmt* del_stmt;
-        const char* del_sql = "DELETE FROM locations WHERE entry_id = ?;";
-        rc = sqlite3_prepare_v2(m_db, del_sql, -1, &del_stmt, 0);
-        check_sqlite(rc, m_db);
-        sqlite3_bind_int(del_stmt, 1, entry.id);
-        sqlite3_step(del_stmt);
-        sqlite3_finalize(del_stmt);
-
-        sqlite3_stmt* loc_stmt;
-        const char* loc_sql = "INSERT INTO locations (entry_id, type, value) VALUES (?, ?, ?);";
-        rc = sqlite3_prepare_v2(m_db, loc_sql, -1, &loc_stmt, 0);
-        check_sqlite(rc, m_db);
-        for (const Location& loc : entry.locations) {
-            sqlite3_bind_int(loc_stmt, 1, entry.id);
-            sqlite3_bind_text(loc_stmt, 2, loc.type.c_str(), -1, SQLITE_STATIC);
-            sqlite3_bind_text(loc_stmt, 3, loc.value.c_str(), -1, SQLITE_STATIC);
-            sqlite3_step(loc_stmt);
-            sqlite3_reset(loc_stmt);
-        }
-        sqlite3_finalize(loc_stmt);
-        exec("COMMIT;");
-    } catch (...) { exec("ROLLBACK;"); throw; }
+    const char* del_sql = "DELETE FROM locations WHERE entry_id = ?;";
+    StatementScope del_stmt(prepare(del_sql));
+    sqlite3_bind_int(del_stmt, 1, entry.id);
+    sqlite3_step(del_stmt);
+
+    const char* loc_sql = "INSERT INTO locations (entry_id, type, value, host_key) VALUES (?, ?, ?, ?);";
+    StatementScope loc_stmt(prepare(loc_sql));
+    for (const Location& loc : entry.locations) {
+        std::string hostKey = UrlMatcher::hostKeyForLocation(loc.type, loc.value);
+        sqlite3_bind_int(loc_stmt, 1, entry.id);
+        sqlite3_bind_text(loc_stmt, 2, loc.type.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(loc_stmt, 3, loc.value.c_str(), -1, SQLITE_STATIC);
+        bind_optional_text(loc_stmt, 4, hostKey);
+        sqlite3_step(loc_stmt);
+        sqlite3_reset(loc_stmt);
+    }
+    txn.commit();
 }
 
 bool Database::entryExists(const std::string& username, const std::string& locationValue) {
-    sqlite3_stmt* stmt;
     const char* sql = R"( SELECT 1 FROM entries e JOIN locations l ON e.id = l.entry_id WHERE e.username = ? AND l.value = ? LIMIT 1; )";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 2, locationValue.c_str(), -1, SQLITE_STATIC);
     bool exists = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
     return exists;
 }
 
 // --- PASSWORD HISTORY ---
 void Database::storePasswordHistory(int entryId, const std::vector<unsigned char>& oldEncryptedPassword) {
-    sqlite3_stmt* stmt;
     const char* sql = "INSERT INTO password_history (entry_id, encrypted_password, changed_at) VALUES (?, ?, ?);";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, entryId);
     sqlite3_bind_blob(stmt, 2, oldEncryptedPassword.data(), oldEncryptedPassword.size(), SQLITE_STATIC);
     sqlite3_bind_int64(stmt, 3, std::time(nullptr));
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+}
+
+void Database::storePasswordHistory(const std::vector<PasswordHistoryEntry>& records) {
+    Transaction txn(*this);
+    const char* sql = "INSERT INTO password_history (entry_id, encrypted_password, changed_at) VALUES (?, ?, ?);";
+    for (const auto& record : records) {
+        StatementScope stmt(prepare(sql));
+        sqlite3_bind_int(stmt, 1, record.entryId);
+        sqlite3_bind_blob(stmt, 2, record.encryptedPassword.data(), record.encryptedPassword.size(), SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 3, record.changedAt);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            throw DBException("Failed to store password history: " + std::string(sqlite3_errmsg(m_db)));
+        }
+    }
+    txn.commit();
 }
 
 std::vector<PasswordHistoryEntry> Database::getPasswordHistory(int entryId) {
     std::vector<PasswordHistoryEntry> history;
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT id, encrypted_password, changed_at FROM password_history WHERE entry_id = ? ORDER BY changed_at DESC;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, entryId);
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         int id = sqlite3_column_int(stmt, 0);
@@ -543,12 +1066,10 @@ std::vector<PasswordHistoryEntry> Database::getPasswordHistory(int entryId) {
         long long changedAt = sqlite3_column_int64(stmt, 2);
         history.emplace_back(id, entryId, encPwd, changedAt);
     }
-    sqlite3_finalize(stmt);
     return history;
 }
 
 void Database::deleteOldPasswordHistory(int entryId, int keepCount) {
-    sqlite3_stmt* stmt;
     const char* sql = R"(
         DELETE FROM password_history 
         WHERE entry_id = ? AND id NOT IN (
@@ -558,85 +1079,80 @@ void Database::deleteOldPasswordHistory(int entryId, int keepCount) {
             LIMIT ?
         );
     )";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, entryId);
     sqlite3_bind_int(stmt, 2, entryId);
     sqlite3_bind_int(stmt, 3, keepCount);
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
 }
 
 // --- ENTRY ACCESS TRACKING ---
 void Database::updateEntryAccessTime(int entryId) {
-    sqlite3_stmt* stmt;
     const char* sql = "UPDATE entries SET last_accessed = ? WHERE id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int64(stmt, 1, std::time(nullptr));
     sqlite3_bind_int(stmt, 2, entryId);
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+}
+
+void Database::updateEntryAccessTimes(const std::unordered_map<int, long long>& accessTimes) {
+    Transaction txn(*this);
+    const char* sql = "UPDATE entries SET last_accessed = ? WHERE id = ?;";
+    StatementScope stmt(prepare(sql));
+    for (const auto& [entryId, accessedAt] : accessTimes) {
+        sqlite3_bind_int64(stmt, 1, accessedAt);
+        sqlite3_bind_int(stmt, 2, entryId);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            throw DBException("Failed to update access time: " + std::string(sqlite3_errmsg(m_db)));
+        }
+        sqlite3_reset(stmt);
+    }
+    txn.commit();
 }
 
 std::vector<VaultEntry> Database::getRecentlyAccessedEntries(int groupId, int limit) {
-    std::vector<VaultEntry> entries;
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id, title, username, notes, created_at, last_modified, last_accessed, password_expiry FROM entries WHERE group_id = ? AND last_accessed > 0 ORDER BY last_accessed DESC LIMIT ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    const char* sql = R"(
+        WITH recent AS (
+            SELECT id FROM entries WHERE group_id = ? AND last_accessed > 0 ORDER BY last_accessed DESC LIMIT ?
+        )
+        SELECT e.id, e.title, e.username, e.notes, e.created_at, e.last_modified, e.last_accessed, e.password_expiry,
+               l.id, l.type, l.value
+        FROM recent r
+        JOIN entries e ON e.id = r.id
+        LEFT JOIN locations l ON l.entry_id = e.id
+        ORDER BY e.last_accessed DESC, e.id, l.id;
+    )";
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, groupId);
     sqlite3_bind_int(stmt, 2, limit);
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        std::string title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        std::string username = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        std::string notes = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        VaultEntry entry(id, title, username, notes);
-        entry.createdAt = sqlite3_column_int64(stmt, 4);
-        entry.lastModified = sqlite3_column_int64(stmt, 5);
-        entry.lastAccessed = sqlite3_column_int64(stmt, 6);
-        entry.passwordExpiry = sqlite3_column_int64(stmt, 7);
-        entry.locations = getLocationsForEntry(id);
-        entries.push_back(std::move(entry));
-    }
-    sqlite3_finalize(stmt);
-    return entries;
+    return readEntriesWithLocations(stmt);
 }
 
 // --- PENDING INVITES ---
 void Database::storePendingInvite(const std::string& senderId, const std::string& groupName, const std::string& payloadJson) {
-    sqlite3_stmt* stmt;
     const char* sql = "INSERT INTO pending_invites (sender_id, group_name, payload_json, timestamp) VALUES (?, ?, ?, ?);";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_text(stmt, 1, senderId.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 2, groupName.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 3, payloadJson.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_int64(stmt, 4, std::time(nullptr));
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
 }
 
 // --- NEW: Update status ---
 void Database::updatePendingInviteStatus(int inviteId, const std::string& status) {
-    sqlite3_stmt* stmt;
     const char* sql = "UPDATE pending_invites SET status = ? WHERE id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_text(stmt, 1, status.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_int(stmt, 2, inviteId);
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
 }
 
 std::vector<PendingInvite> Database::getPendingInvites() {
     std::vector<PendingInvite> invites;
     // UPDATED: Now fetching status
     const char* sql = "SELECT id, sender_id, group_name, payload_json, timestamp, status FROM pending_invites ORDER BY timestamp DESC;";
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         PendingInvite invite;
         invite.id = sqlite3_column_int(stmt, 0);
@@ -649,75 +1165,73 @@ std::vector<PendingInvite> Database::getPendingInvites() {
         invite.status = statusText ? reinterpret_cast<const char*>(statusText) : "pending";
         invites.push_back(invite);
     }
-    sqlite3_finalize(stmt);
     return invites;
 }
 
 void Database::deletePendingInvite(int inviteId) {
-    sqlite3_stmt* stmt;
     const char* sql = "DELETE FROM pending_invites WHERE id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, inviteId);
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
 }
 
 // --- MEMBERS ---
 void Database::addGroupMember(int groupId, const std::string& userId, const std::string& role, const std::string& status) {
-    sqlite3_stmt* stmt;
     const char* sql = "INSERT OR REPLACE INTO group_members (group_id, user_id, role, status) VALUES (?, ?, ?, ?);";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, groupId);
     sqlite3_bind_text(stmt, 2, userId.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 3, role.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 4, status.c_str(), -1, SQLITE_STATIC);
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+}
+
+void Database::addGroupMembers(int groupId, const std::vector<GroupMember>& members) {
+    Transaction txn(*this);
+    const char* sql = "INSERT OR REPLACE INTO group_members (group_id, user_id, role, status) VALUES (?, ?, ?, ?);";
+    for (const auto& member : members) {
+        StatementScope stmt(prepare(sql));
+        sqlite3_bind_int(stmt, 1, groupId);
+        sqlite3_bind_text(stmt, 2, member.userId.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, member.role.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 4, member.status.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            throw DBException("Failed to add group member: " + std::string(sqlite3_errmsg(m_db)));
+        }
+    }
+    txn.commit();
 }
 
 void Database::removeGroupMember(int groupId, const std::string& userId) {
-    sqlite3_stmt* stmt;
     const char* sql = "DELETE FROM group_members WHERE group_id = ? AND user_id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, groupId);
     sqlite3_bind_text(stmt, 2, userId.c_str(), -1, SQLITE_STATIC);
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
 }
 
 void Database::updateGroupMemberRole(int groupId, const std::string& userId, const std::string& newRole) {
-    sqlite3_stmt* stmt;
     const char* sql = "UPDATE group_members SET role = ? WHERE group_id = ? AND user_id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_text(stmt, 1, newRole.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_int(stmt, 2, groupId);
     sqlite3_bind_text(stmt, 3, userId.c_str(), -1, SQLITE_STATIC);
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
 }
 
 void Database::updateGroupMemberStatus(int groupId, const std::string& userId, const std::string& newStatus) {
-    sqlite3_stmt* stmt;
     const char* sql = "UPDATE group_members SET status = ? WHERE group_id = ? AND user_id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_text(stmt, 1, newStatus.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_int(stmt, 2, groupId);
     sqlite3_bind_text(stmt, 3, userId.c_str(), -1, SQLITE_STATIC);
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
 }
 
 std::vector<GroupMember> Database::getGroupMembers(int groupId) {
     std::vector<GroupMember> members;
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT user_id, role, status FROM group_members WHERE group_id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, groupId);
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         GroupMember m;
@@ -726,47 +1240,37 @@ std::vector<GroupMember> Database::getGroupMembers(int groupId) {
         m.status = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
         members.push_back(m);
     }
-    sqlite3_finalize(stmt);
     return members;
 }
 
 void Database::setGroupPermissions(int groupId, bool adminsOnly) {
-    sqlite3_stmt* stmt;
     const char* sql = "INSERT OR REPLACE INTO group_settings (group_id, admins_only_write) VALUES (?, ?);";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, groupId);
     sqlite3_bind_int(stmt, 2, adminsOnly ? 1 : 0);
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
 }
 
 GroupPermissions Database::getGroupPermissions(int groupId) {
     GroupPermissions p;
     p.adminsOnlyWrite = false;
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT admins_only_write FROM group_settings WHERE group_id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, groupId);
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         p.adminsOnlyWrite = (sqlite3_column_int(stmt, 0) != 0);
     }
-    sqlite3_finalize(stmt);
     return p;
 }
 
 std::string Database::getGroupOwner(int groupId) {
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT owner_id FROM groups WHERE id = ?;";
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, 0);
-    check_sqlite(rc, m_db);
+    StatementScope stmt(prepare(sql));
     sqlite3_bind_int(stmt, 1, groupId);
     std::string owner = "me";
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         owner = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
     }
-    sqlite3_finalize(stmt);
     return owner;
 }
 
@@ -5,21 +5,59 @@
 #include <vector>
 #include <stdexcept>
 #include <map> 
+#include <unordered_map>
 
 struct sqlite3;
+struct sqlite3_stmt;
 
 namespace CipherMesh {
 namespace Core {
 
+struct StatementCacheStats {
+    size_t hits;
+    size_t misses;
+    size_t cachedStatements;
+};
+
+// Encrypted password of one entry or password_history row, by row id
+struct EncryptedPasswordRow {
+    int id;
+    std::vector<unsigned char> encryptedPassword;
+};
+
+// Connection settings applied by Database::open()
+struct StorageOptions {
+    bool walMode = true;                // journal_mode=WAL so readers never block on the writer
+    int busyTimeoutMs = 5000;           // how long SQLite waits for a lock held by another process
+    int busyRetries = 3;                // extra attempts for BEGIN/COMMIT still busy after the timeout
+    int busyRetryDelayMs = 50;          // linear backoff step between those attempts
+    int walAutoCheckpointPages = 1000;  // WAL size (in pages) that triggers an automatic checkpoint
+};
+
 class Database {
+    friend class Transaction;
 public:
+    // Latest schema version, stored in PRAGMA user_version
+    static const int SCHEMA_VERSION = 4;
+
     Database();
     ~Database();
 
-    void open(const std::string& path);
+    void open(const std::string& path, const StorageOptions& options = StorageOptions());
     void close();
     bool isOpen() const { return m_db != nullptr; }
+    // True while a Transaction guard is open on this connection
+    bool inTransaction() const { return m_transactionDepth > 0; }
+    // Creates a new schema or upgrades an existing vault in place, in one transaction
     void createTables();
+    int getSchemaVersion();
+    std::string getJournalMode();
+    // Changes whenever another connection (e.g. another process) commits
+    // to the file; our own writes leave it unchanged
+    long long getDataVersion();
+    // Copies WAL content back into the database file. A truncating checkpoint
+    // also resets the WAL file; it waits for readers and may fail while busy.
+    bool checkpoint(bool truncate = false);
 
     void storeMetadata(const std::string& key, const std::vector<unsigned char>& value);
     std::vector<unsigned char> getMetadata(const std::string& key);
@@ -34,25 +72,64 @@ public:
     
     std::map<int, std::vector<unsigned char>> getAllEncryptedGroupKeys();
     void updateEncryptedGroupKey(int groupId, const std::vector<unsigned char>& newKey);
+    // Writes re-wrapped group keys and the matching metadata (salt, canary,
+    // KDF parameters) in one transaction, so a vault is never left half re-keyed
+    void replaceKeyMaterial(const std::map<int, std::vector<unsigned char>>& encryptedGroupKeys,
+                            const std::map<std::string, std::vector<unsigned char>>& metadata);
 
     void storeEntry(int groupId, VaultEntry& entry, const std::vector<unsigned char>& encryptedPassword);
+    // Bulk insert in one transaction; encryptedPasswords[i] belongs to entries[i]
+    void storeEntries(int groupId, std::vector<VaultEntry>& entries, const std::vector<std::vector<unsigned char>>& encryptedPasswords);
     std::vector<VaultEntry> getEntriesForGroup(int groupId);
+    VaultEntry getEntry(int entryId);
+    std::vector<int> getEntryIds();
+    // Entries of any group with last_modified >= 'modifiedSince' or an id
+    // above 'afterId', in id order: what another connection may have added
+    // or changed since a reader last looked
+    std::vector<VaultEntry> getEntriesChangedSince(long long modifiedSince, int afterId);
+    // Up to 'limit' entries of a group in getEntriesForGroup order, resuming
+    // after 'pageToken' (empty for the first page). Keyset pagination served
+    // by idx_entries_group_title, so every page costs the same however deep.
+    EntryPage getEntriesForGroupPage(int groupId, int limit, const std::string& pageToken);
+    // Shared with the in-memory listing in Vault: decodes a page request
+    // (throws DBException on a bad limit or token) and turns 'limit' + 1
+    // fetched entries into a page, the extra one only telling that more follow
+    static void decodePageRequest(int limit, const std::string& pageToken, std::string& afterTitle, int& afterId);
+    static EntryPage makeEntryPage(std::vector<VaultEntry> entries, int limit);
+    // Same scan as getEntriesForGroup, also returning each entry's encrypted
+    // password (encryptedPasswords[i] belongs to the i-th returned entry)
+    std::vector<VaultEntry> getEntriesWithPasswordsForGroup(int groupId, std::vector<std::vector<unsigned char>>& encryptedPasswords);
+    // Every blob encrypted with the group's key: entry passwords and the
+    // password history of those entries
+    std::vector<EncryptedPasswordRow> getEncryptedPasswordsForGroup(int groupId);
+    std::vector<EncryptedPasswordRow> getEncryptedPasswordHistoryForGroup(int groupId);
+    // Bulk rewrite of such blobs (after a group key rotation), each in one transaction
+    void updateEncryptedPasswords(const std::vector<EncryptedPasswordRow>& rows);
+    void updateEncryptedPasswordHistory(const std::vector<EncryptedPasswordRow>& rows);
     bool deleteEntry(int entryId);
     void updateEntry(const VaultEntry& entry, const std::vector<unsigned char>* newEncryptedPassword);
     
     std::vector<Location> getLocationsForEntry(int entryId);
+    // Site-aware lookup for autofill: exact value, same host, then same registrable domain
     std::vector<VaultEntry> findEntriesByLocation(const std::string& locationValue); 
+    // Ranked (bm25) full-text search over title, username, notes and locations
     std::vector<VaultEntry> searchEntries(const std::string& searchTerm); 
     std::vector<unsigned char> getEncryptedPassword(int entryId);
+    // Same, also returning the entry's group id (one lookup instead of two)
+    std::vector<unsigned char> getEncryptedPassword(int entryId, int& groupId);
     bool entryExists(const std::string& username, const std::string& locationValue);
 
     // Password history
     void storePasswordHistory(int entryId, const std::vector<unsigned char>& oldEncryptedPassword);
+    // Bulk insert in one transaction; keeps each record's entryId and changedAt
+    void storePasswordHistory(const std::vector<PasswordHistoryEntry>& records);
     std::vector<PasswordHistoryEntry> getPasswordHistory(int entryId);
     void deleteOldPasswordHistory(int entryId, int keepCount); // Keep only last N passwords
     
     // Entry access tracking
     void updateEntryAccessTime(int entryId);
+    // Batched version in one transaction: entry id -> access time
+    void updateEntryAccessTimes(const std::unordered_map<int, long long>& accessTimes);
     std::vector<VaultEntry> getRecentlyAccessedEntries(int groupId, int limit);
 
     // --- UPDATED: Pending Invites ---
@@ -63,6 +140,8 @@ public:
 
     // Members
     void addGroupMember(int groupId, const std::string& userId, const std::string& role, const std::string& status);
+    // Bulk version of addGroupMember, in one transaction
+    void addGroupMembers(int groupId, const std::vector<GroupMember>& members);
     void removeGroupMember(int groupId, const std::string& userId);
     void updateGroupMemberRole(int groupId, const std::string& userId, const std::string& newRole);
     void updateGroupMemberStatus(int groupId, const std::string& userId, const std::string& newStatus);
@@ -72,9 +151,53 @@ public:
     GroupPermissions getGroupPermissions(int groupId);
     std::string getGroupOwner(int groupId);
 
+    // Prepared statement cache counters (reset when the connection is closed)
+    StatementCacheStats getStatementCacheStats() const;
+
 private:
     sqlite3* m_db;
+    StorageOptions m_options;
+    bool m_hasSearchIndex;
+    int m_transactionDepth; // open Transaction guards
     void exec(const std::string& sql);
+    bool tableExists(const std::string& table);
+    bool columnExists(const std::string& table, const std::string& column);
+    std::vector<VaultEntry> searchEntriesByScan(const std::string& searchTerm);
+    void insertEntry(int groupId, VaultEntry& entry, const std::vector<unsigned char>& encryptedPassword, long long now);
+
+    // Schema migration steps, applied in order by createTables()
+    void migrateToV1();
+    void migrateToV2();
+    void migrateToV3();
+    void migrateToV4();
+
+    // Statements are prepared once per connection and finalized in close()
+    sqlite3_stmt* prepare(const std::string& sql);
+    std::unordered_map<std::string, sqlite3_stmt*> m_stmtCache;
+    size_t m_stmtCacheHits;
+    size_t m_stmtCacheMisses;
+};
+
+// Scoped write transaction. The outermost guard on a connection runs
+// BEGIN IMMEDIATE ... COMMIT; guards opened inside it become savepoints, so
+// an operation that opens one can run alone or as one step of a larger
+// operation and the whole thing still commits (and syncs) once. A guard
+// destroyed without commit() rolls back its own work only.
+class Transaction {
+public:
+    explicit Transaction(Database& db);
+    ~Transaction();
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+
+    void commit();
+
+private:
+    Database& m_db;
+    int m_depth;    // 1 for the outermost guard
+    bool m_open;
+    std::string savepointName() const;
+    void close();
 };
 
 class DBException : public std::runtime_error {
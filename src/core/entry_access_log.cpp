@@ -0,0 +1,62 @@
+#include "entry_access_log.hpp"
+#include <algorithm>
+
+namespace CipherMesh {
+namespace Core {
+
+void EntryAccessLog::loadRecent(int groupId, const std::vector<int>& entryIds) {
+    std::vector<int>& list = m_recent[groupId];
+    list.assign(entryIds.begin(), entryIds.begin() + std::min(entryIds.size(), RECENT_CAPACITY));
+}
+
+void EntryAccessLog::record(int groupId, int entryId, long long timestamp) {
+    std::vector<int>& list = m_recent[groupId];
+    auto found = std::find(list.begin(), list.end(), entryId);
+    if (found == list.end()) {
+        if (list.size() < RECENT_CAPACITY) {
+            list.push_back(entryId);
+        } else {
+            list.back() = entryId;
+        }
+        found = list.end() - 1;
+    }
+    std::rotate(list.begin(), found, found + 1);
+
+    if (m_pending.empty()) {
+        m_oldestPending = timestamp;
+    }
+    m_pending[entryId] = timestamp;
+}
+
+std::vector<int> EntryAccessLog::recent(int groupId, size_t limit) const {
+    auto found = m_recent.find(groupId);
+    if (found == m_recent.end()) {
+        return {};
+    }
+    const std::vector<int>& list = found->second;
+    return std::vector<int>(list.begin(), list.begin() + std::min(list.size(), limit));
+}
+
+void EntryAccessLog::removeEntry(int entryId) {
+    for (auto& [groupId, list] : m_recent) {
+        list.erase(std::remove(list.begin(), list.end(), entryId), list.end());
+    }
+    m_pending.erase(entryId);
+}
+
+void EntryAccessLog::removeGroup(int groupId) {
+    m_recent.erase(groupId);
+}
+
+void EntryAccessLog::clear() {
+    m_recent.clear();
+    clearPending();
+}
+
+void EntryAccessLog::clearPending() {
+    m_pending.clear();
+    m_oldestPending = 0;
+}
+
+}
+}
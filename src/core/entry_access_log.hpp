@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace CipherMesh {
+namespace Core {
+
+// Entry accesses not yet written to the database, plus the most recently
+// accessed entries of each group, most recent first. Lets Vault answer
+// getRecentlyAccessedEntries from memory and write access times in batches
+// instead of one UPDATE per selection.
+// Not thread-safe; owned by a single Vault.
+class EntryAccessLog {
+public:
+    // Entries remembered per group
+    static const size_t RECENT_CAPACITY = 32;
+
+    // Whether the group's recent list has been seeded (see loadRecent)
+    bool hasRecent(int groupId) const { return m_recent.count(groupId) != 0; }
+    // Seeds the group's recent list from storage, most recent first
+    void loadRecent(int groupId, const std::vector<int>& entryIds);
+    // Moves the entry to the front of its group's list and marks the new
+    // access time for the next flush. The group's list must be loaded.
+    void record(int groupId, int entryId, long long timestamp);
+    // Up to 'limit' entry ids of the group, most recent first
+    std::vector<int> recent(int groupId, size_t limit) const;
+
+    void removeEntry(int entryId);
+    void removeGroup(int groupId);
+    void clear();
+
+    // Access times recorded since the last clearPending(), by entry id
+    const std::unordered_map<int, long long>& pending() const { return m_pending; }
+    // Access time of the oldest pending entry, 0 if none
+    long long oldestPending() const { return m_oldestPending; }
+    void clearPending();
+
+private:
+    std::unordered_map<int, std::vector<int>> m_recent; // by group id, at most RECENT_CAPACITY each
+    std::unordered_map<int, long long> m_pending;
+    long long m_oldestPending = 0;
+};
+
+}
+}
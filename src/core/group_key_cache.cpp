@@ -0,0 +1,106 @@
+#include <sodium.h>
+#include "group_key_cache.hpp"
+#include "crypto.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace CipherMesh {
+namespace Core {
+
+GroupKeyCache::GroupKeyCache(size_t capacity)
+    : m_capacity(capacity), m_keys(nullptr), m_slots(capacity), m_clock(0),
+      m_hits(0), m_misses(0), m_evictions(0) {}
+
+GroupKeyCache::~GroupKeyCache() {
+    // sodium_free() zeroes the region before releasing it
+    if (m_keys) {
+        sodium_free(m_keys);
+    }
+}
+
+unsigned char* GroupKeyCache::keyBytes(size_t slot) const {
+    return m_keys + slot * Crypto::KEY_SIZE;
+}
+
+void GroupKeyCache::wipeSlot(size_t slot) {
+    sodium_memzero(keyBytes(slot), Crypto::KEY_SIZE);
+    m_slots[slot] = Slot();
+}
+
+bool GroupKeyCache::lookup(int groupId, SecureBuffer& key) {
+    if (m_keys) {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (m_slots[i].groupId == groupId) {
+                m_slots[i].lastUse = ++m_clock;
+                key = SecureBuffer(keyBytes(i), Crypto::KEY_SIZE);
+                ++m_hits;
+                return true;
+            }
+        }
+    }
+    ++m_misses;
+    return false;
+}
+
+void GroupKeyCache::insert(int groupId, const SecureBuffer& key) {
+    if (m_capacity == 0 || groupId < 0) return;
+    if (key.size() != Crypto::KEY_SIZE) {
+        throw std::runtime_error("Invalid key size for group key cache.");
+    }
+    if (!m_keys) {
+        m_keys = static_cast<unsigned char*>(sodium_malloc(m_capacity * Crypto::KEY_SIZE));
+        if (!m_keys) {
+            throw std::runtime_error("Failed to allocate locked memory for group key cache.");
+        }
+    }
+
+    // Reuse the group's slot, else a free one, else the least recently used
+    size_t target = m_capacity;
+    for (size_t i = 0; i < m_capacity && target == m_capacity; ++i) {
+        if (m_slots[i].groupId == groupId) target = i;
+    }
+    for (size_t i = 0; i < m_capacity && target == m_capacity; ++i) {
+        if (m_slots[i].groupId == -1) target = i;
+    }
+    if (target == m_capacity) {
+        target = 0;
+        for (size_t i = 1; i < m_capacity; ++i) {
+            if (m_slots[i].lastUse < m_slots[target].lastUse) target = i;
+        }
+        wipeSlot(target);
+        ++m_evictions;
+    }
+
+    std::copy(key.begin(), key.end(), keyBytes(target));
+    m_slots[target].groupId = groupId;
+    m_slots[target].lastUse = ++m_clock;
+}
+
+void GroupKeyCache::erase(int groupId) {
+    if (!m_keys) return;
+    for (size_t i = 0; i < m_capacity; ++i) {
+        if (m_slots[i].groupId == groupId) {
+            wipeSlot(i);
+        }
+    }
+}
+
+void GroupKeyCache::clear() {
+    if (m_keys) {
+        sodium_memzero(m_keys, m_capacity * Crypto::KEY_SIZE);
+    }
+    for (Slot& slot : m_slots) {
+        slot = Slot();
+    }
+}
+
+GroupKeyCacheStats GroupKeyCache::getStats() const {
+    size_t cached = 0;
+    for (const Slot& slot : m_slots) {
+        if (slot.groupId != -1) ++cached;
+    }
+    return GroupKeyCacheStats{ m_hits, m_misses, m_evictions, cached, m_capacity };
+}
+
+}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "secure_buffer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace CipherMesh {
+namespace Core {
+
+struct GroupKeyCacheStats {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t cachedKeys;
+    size_t capacity;
+};
+
+// Small LRU cache of unwrapped group keys, keyed by group id. Key bytes live
+// in one sodium_malloc() region (locked, guard-paged, never swapped) that is
+// allocated on first use and zeroed whenever an entry is dropped.
+// Not thread-safe; owned by a single Vault.
+class GroupKeyCache {
+public:
+    static const size_t DEFAULT_CAPACITY = 16;
+
+    explicit GroupKeyCache(size_t capacity = DEFAULT_CAPACITY);
+    ~GroupKeyCache();
+    GroupKeyCache(const GroupKeyCache&) = delete;
+    GroupKeyCache& operator=(const GroupKeyCache&) = delete;
+
+    // Copies the cached key for 'groupId' into 'key'. Returns false on a miss.
+    bool lookup(int groupId, SecureBuffer& key);
+    // Caches 'key' for 'groupId', evicting the least recently used key if full
+    void insert(int groupId, const SecureBuffer& key);
+    void erase(int groupId);
+    // Wipes every cached key (the locked region is kept for reuse)
+    void clear();
+
+    GroupKeyCacheStats getStats() const;
+
+private:
+    struct Slot {
+        int groupId = -1;       // -1 marks a free slot
+        uint64_t lastUse = 0;
+    };
+
+    unsigned char* keyBytes(size_t slot) const;
+    void wipeSlot(size_t slot);
+
+    size_t m_capacity;
+    unsigned char* m_keys;      // m_capacity * Crypto::KEY_SIZE bytes from sodium_malloc
+    std::vector<Slot> m_slots;
+    uint64_t m_clock;
+    size_t m_hits;
+    size_t m_misses;
+    size_t m_evictions;
+};
+
+}
+}
@@ -0,0 +1,536 @@
+#include "metadata_index.hpp"
+#include "url_matcher.hpp"
+#include <algorithm>
+#include <string_view>
+
+namespace CipherMesh {
+namespace Core {
+
+namespace {
+
+// Dead space is reclaimed once it outweighs live data and is worth a rebuild
+const size_t MIN_COMPACTION_SLOTS = 1024;
+const size_t MIN_COMPACTION_TEXT = 64 * 1024;
+
+enum Field { TITLE = 0, USERNAME = 1, LOCATION = 2, NOTES = 3 };
+
+// ASCII folding, as SQLite's LIKE does
+void appendLower(std::string& out, const std::string& value) {
+    for (char c : value) {
+        out += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+}
+
+size_t codepointCount(const std::string& value) {
+    size_t count = 0;
+    for (unsigned char c : value) {
+        if ((c & 0xC0) != 0x80) ++count;
+    }
+    return count;
+}
+
+// Bound as a C string by the SQL path, so nothing after a NUL takes part
+std::string searchNeedle(const std::string& searchTerm) {
+    std::string needle;
+    appendLower(needle, searchTerm.substr(0, searchTerm.find('\0')));
+    return needle;
+}
+
+// Notes are only searched through the full-text index, i.e. for 3+ characters
+bool searchesNotes(const std::string& needle) {
+    return codepointCount(needle) >= 3;
+}
+
+}
+
+MetadataIndex::MetadataIndex()
+    : m_ready(false), m_revision(0), m_deadLocations(0), m_staleHostPairs(0), m_deadText(0) {}
+
+void MetadataIndex::clear() {
+    // Swap with an empty index so capacity is released too
+    unsigned long long revision = m_revision + 1;
+    MetadataIndex empty;
+    std::swap(*this, empty);
+    m_revision = revision;
+}
+
+void MetadataIndex::setReady() {
+    std::sort(m_byHost.begin(), m_byHost.end());
+    for (auto& [groupId, order] : m_groupOrder) {
+        std::sort(order.begin(), order.end(), [this](int a, int b) { return entryBefore(a, b); });
+    }
+    m_ready = true;
+}
+
+void MetadataIndex::addEntry(int groupId, const VaultEntry& entry) {
+    removeEntry(entry.id);
+    ++m_revision;
+
+    size_t row = m_ids.size();
+    m_ids.push_back(entry.id);
+    m_groupIds.push_back(groupId);
+    m_titles.push_back(entry.title);
+    m_usernames.push_back(entry.username);
+    m_notes.push_back(entry.notes);
+    m_createdAt.push_back(entry.createdAt);
+    m_lastModified.push_back(entry.lastModified);
+    m_lastAccessed.push_back(entry.lastAccessed);
+    m_passwordExpiry.push_back(entry.passwordExpiry);
+    m_locFirst.push_back(0);
+    m_locCount.push_back(0);
+    m_textOffset.push_back(0);
+    m_rowById[entry.id] = row;
+    insertIntoGroupOrder(row);
+
+    appendLocations(row, entry.locations);
+    appendText(row);
+}
+
+void MetadataIndex::insertIntoGroupOrder(size_t row) {
+    std::vector<int>& order = m_groupOrder[m_groupIds[row]];
+    if (!m_ready) {
+        order.push_back(m_ids[row]);
+        return;
+    }
+    auto it = std::lower_bound(order.begin(), order.end(), m_ids[row], [this, row](int entryId, int) {
+        return entryBefore(entryId, m_titles[row], m_ids[row]);
+    });
+    order.insert(it, m_ids[row]);
+}
+
+void MetadataIndex::eraseFromGroupOrder(size_t row) {
+    auto found = m_groupOrder.find(m_groupIds[row]);
+    if (found == m_groupOrder.end()) {
+        return; // removeGroup dropped the whole order first
+    }
+    std::vector<int>& order = found->second;
+    auto it = m_ready
+        ? std::lower_bound(order.begin(), order.end(), m_ids[row], [this, row](int entryId, int) {
+              return entryBefore(entryId, m_titles[row], m_ids[row]);
+          })
+        : std::find(order.begin(), order.end(), m_ids[row]);
+    if (it != order.end() && *it == m_ids[row]) {
+        order.erase(it);
+    }
+    if (order.empty()) {
+        m_groupOrder.erase(found);
+    }
+}
+
+void MetadataIndex::addEntries(int groupId, const std::vector<VaultEntry>& entries) {
+    // Append host pairs unsorted as during the initial load; one sort beats
+    // a sorted insert per location
+    bool ready = m_ready;
+    m_ready = false;
+    for (const VaultEntry& entry : entries) {
+        addEntry(groupId, entry);
+    }
+    if (ready) {
+        setReady();
+    }
+}
+
+void MetadataIndex::appendLocations(size_t row, const std::vector<Location>& locations) {
+    m_locFirst[row] = static_cast<uint32_t>(m_locIds.size());
+    m_locCount[row] = static_cast<uint32_t>(locations.size());
+    for (const Location& loc : locations) {
+        std::string hostKey = UrlMatcher::hostKeyForLocation(loc.type, loc.value);
+        m_locIds.push_back(loc.id);
+        m_locTypes.push_back(loc.type);
+        m_locValues.push_back(loc.value);
+        m_byValue[loc.value].push_back(m_ids[row]);
+        if (!hostKey.empty()) {
+            std::pair<std::string, int> pair(hostKey, m_ids[row]);
+            if (m_ready) {
+                m_byHost.insert(std::lower_bound(m_byHost.begin(), m_byHost.end(), pair), std::move(pair));
+            } else {
+                m_byHost.push_back(std::move(pair));
+            }
+        }
+        m_locHostKeys.push_back(std::move(hostKey));
+    }
+}
+
+size_t MetadataIndex::textLength(size_t row) const {
+    size_t length = m_titles[row].size() + 1 + m_usernames[row].size() + 1 + m_notes[row].size() + 1;
+    for (uint32_t i = 0; i < m_locCount[row]; ++i) {
+        length += m_locValues[m_locFirst[row] + i].size() + 1;
+    }
+    return length;
+}
+
+void MetadataIndex::appendText(size_t row) {
+    m_textOffset[row] = m_text.size();
+    m_textSegments.emplace_back(m_text.size(), m_ids[row]);
+    appendLower(m_text, m_titles[row]);
+    m_text += '\0';
+    appendLower(m_text, m_usernames[row]);
+    m_text += '\0';
+    for (uint32_t i = 0; i < m_locCount[row]; ++i) {
+        appendLower(m_text, m_locValues[m_locFirst[row] + i]);
+        m_text += '\0';
+    }
+    appendLower(m_text, m_notes[row]);
+    m_text += '\0';
+}
+
+// Which field a match starting 'offset' bytes into the row's segment is in
+int MetadataIndex::fieldAt(size_t row, size_t offset) const {
+    size_t end = m_titles[row].size();
+    if (offset < end) return TITLE;
+    end += 1 + m_usernames[row].size();
+    if (offset < end) return USERNAME;
+    for (uint32_t i = 0; i < m_locCount[row]; ++i) {
+        end += 1 + m_locValues[m_locFirst[row] + i].size();
+        if (offset < end) return LOCATION;
+    }
+    return NOTES;
+}
+
+bool MetadataIndex::removeEntry(int entryId) {
+    auto found = m_rowById.find(entryId);
+    if (found == m_rowById.end()) {
+        return false;
+    }
+    size_t row = found->second;
+    ++m_revision;
+    eraseFromGroupOrder(row);
+
+    for (uint32_t i = 0; i < m_locCount[row]; ++i) {
+        size_t slot = m_locFirst[row] + i;
+        auto byValue = m_byValue.find(m_locValues[slot]);
+        if (byValue != m_byValue.end()) {
+            std::vector<int>& ids = byValue->second;
+            ids.erase(std::remove(ids.begin(), ids.end(), entryId), ids.end());
+            if (ids.empty()) m_byValue.erase(byValue);
+        }
+        if (!m_locHostKeys[slot].empty()) ++m_staleHostPairs;
+    }
+    m_deadLocations += m_locCount[row];
+
+    // Zero the text so it can never match again
+    size_t length = textLength(row);
+    std::fill(m_text.begin() + m_textOffset[row], m_text.begin() + m_textOffset[row] + length, '\0');
+    auto segment = std::lower_bound(m_textSegments.begin(), m_textSegments.end(), std::make_pair(m_textOffset[row], -1));
+    if (segment != m_textSegments.end() && segment->first == m_textOffset[row]) {
+        segment->second = -1;
+    }
+    m_deadText += length;
+
+    // Swap the last row into the hole
+    size_t last = m_ids.size() - 1;
+    if (row != last) {
+        m_ids[row] = m_ids[last];
+        m_groupIds[row] = m_groupIds[last];
+        m_titles[row] = std::move(m_titles[last]);
+        m_usernames[row] = std::move(m_usernames[last]);
+        m_notes[row] = std::move(m_notes[last]);
+        m_createdAt[row] = m_createdAt[last];
+        m_lastModified[row] = m_lastModified[last];
+        m_lastAccessed[row] = m_lastAccessed[last];
+        m_passwordExpiry[row] = m_passwordExpiry[last];
+        m_locFirst[row] = m_locFirst[last];
+        m_locCount[row] = m_locCount[last];
+        m_textOffset[row] = m_textOffset[last];
+        m_rowById[m_ids[row]] = row;
+    }
+    m_ids.pop_back();
+    m_groupIds.pop_back();
+    m_titles.pop_back();
+    m_usernames.pop_back();
+    m_notes.pop_back();
+    m_createdAt.pop_back();
+    m_lastModified.pop_back();
+    m_lastAccessed.pop_back();
+    m_passwordExpiry.pop_back();
+    m_locFirst.pop_back();
+    m_locCount.pop_back();
+    m_textOffset.pop_back();
+    m_rowById.erase(entryId);
+
+    if (m_deadLocations > MIN_COMPACTION_SLOTS && m_deadLocations * 2 > m_locIds.size()) {
+        compactLocations();
+    }
+    if (m_deadText > MIN_COMPACTION_TEXT && m_deadText * 2 > m_text.size()) {
+        compactText();
+    }
+    if (m_staleHostPairs > MIN_COMPACTION_SLOTS && m_staleHostPairs * 2 > m_byHost.size()) {
+        rebuildHostIndex();
+    }
+    return true;
+}
+
+void MetadataIndex::removeGroup(int groupId) {
+    auto found = m_groupOrder.find(groupId);
+    if (found == m_groupOrder.end()) {
+        return;
+    }
+    std::vector<int> ids = std::move(found->second);
+    m_groupOrder.erase(found);
+    for (int id : ids) {
+        removeEntry(id);
+    }
+}
+
+void MetadataIndex::setLastAccessed(int entryId, long long timestamp) {
+    auto found = m_rowById.find(entryId);
+    if (found != m_rowById.end()) {
+        m_lastAccessed[found->second] = timestamp;
+    }
+}
+
+void MetadataIndex::compactLocations() {
+    std::vector<int> ids;
+    std::vector<std::string> types, values, hostKeys;
+    size_t live = m_locIds.size() - m_deadLocations;
+    ids.reserve(live);
+    types.reserve(live);
+    values.reserve(live);
+    hostKeys.reserve(live);
+    for (size_t row = 0; row < m_ids.size(); ++row) {
+        uint32_t first = m_locFirst[row];
+        m_locFirst[row] = static_cast<uint32_t>(ids.size());
+        for (uint32_t i = 0; i < m_locCount[row]; ++i) {
+            ids.push_back(m_locIds[first + i]);
+            types.push_back(std::move(m_locTypes[first + i]));
+            values.push_back(std::move(m_locValues[first + i]));
+            hostKeys.push_back(std::move(m_locHostKeys[first + i]));
+        }
+    }
+    m_locIds.swap(ids);
+    m_locTypes.swap(types);
+    m_locValues.swap(values);
+    m_locHostKeys.swap(hostKeys);
+    m_deadLocations = 0;
+}
+
+void MetadataIndex::compactText() {
+    std::string text;
+    text.reserve(m_text.size() - m_deadText);
+    m_text.swap(text);
+    m_textSegments.clear();
+    for (size_t row = 0; row < m_ids.size(); ++row) {
+        appendText(row);
+    }
+    m_deadText = 0;
+}
+
+void MetadataIndex::rebuildHostIndex() {
+    m_byHost.clear();
+    for (size_t row = 0; row < m_ids.size(); ++row) {
+        for (uint32_t i = 0; i < m_locCount[row]; ++i) {
+            const std::string& hostKey = m_locHostKeys[m_locFirst[row] + i];
+            if (!hostKey.empty()) m_byHost.emplace_back(hostKey, m_ids[row]);
+        }
+    }
+    std::sort(m_byHost.begin(), m_byHost.end());
+    m_staleHostPairs = 0;
+}
+
+bool MetadataIndex::hasHostKey(size_t row, const std::string& hostKey) const {
+    for (uint32_t i = 0; i < m_locCount[row]; ++i) {
+        if (m_locHostKeys[m_locFirst[row] + i] == hostKey) return true;
+    }
+    return false;
+}
+
+VaultEntry MetadataIndex::materialize(size_t row) const {
+    VaultEntry entry(m_ids[row], m_titles[row], m_usernames[row], m_notes[row]);
+    entry.createdAt = m_createdAt[row];
+    entry.lastModified = m_lastModified[row];
+    entry.lastAccessed = m_lastAccessed[row];
+    entry.passwordExpiry = m_passwordExpiry[row];
+    entry.locations.reserve(m_locCount[row]);
+    for (uint32_t i = 0; i < m_locCount[row]; ++i) {
+        size_t slot = m_locFirst[row] + i;
+        entry.locations.emplace_back(m_locIds[slot], m_locTypes[slot], m_locValues[slot]);
+    }
+    return entry;
+}
+
+std::vector<VaultEntry> MetadataIndex::getEntriesForGroup(int groupId) const {
+    std::vector<VaultEntry> entries;
+    auto found = m_groupOrder.find(groupId);
+    if (found == m_groupOrder.end()) {
+        return entries;
+    }
+    entries.reserve(found->second.size());
+    for (int entryId : found->second) {
+        entries.push_back(materialize(m_rowById.at(entryId)));
+    }
+    return entries;
+}
+
+std::vector<VaultEntry> MetadataIndex::getEntriesForGroup(int groupId, const std::string& afterTitle, int afterId, size_t limit) const {
+    std::vector<VaultEntry> entries;
+    auto found = m_groupOrder.find(groupId);
+    if (found == m_groupOrder.end()) {
+        return entries;
+    }
+    const std::vector<int>& order = found->second;
+    // Skip entries at or before the cursor: (title, id) <= (afterTitle, afterId)
+    auto it = std::partition_point(order.begin(), order.end(), [this, &afterTitle, afterId](int entryId) {
+        return entryBefore(entryId, afterTitle, afterId + 1);
+    });
+    for (; it != order.end() && entries.size() < limit; ++it) {
+        entries.push_back(materialize(m_rowById.at(*it)));
+    }
+    return entries;
+}
+
+// ORDER BY e.title, e.id (binary collation): whether entry 'entryId' sorts
+// before (title, id)
+bool MetadataIndex::entryBefore(int entryId, const std::string& title, int id) const {
+    int order = m_titles[m_rowById.at(entryId)].compare(title);
+    return order != 0 ? order < 0 : entryId < id;
+}
+
+bool MetadataIndex::entryBefore(int a, int b) const {
+    return entryBefore(a, m_titles[m_rowById.at(b)], b);
+}
+
+std::vector<VaultEntry> MetadataIndex::findEntriesByLocation(const std::string& locationValue) const {
+    // Ranks as in Database::findEntriesByLocation: exact value, same host, same site
+    std::unordered_map<int, int> rankById;
+    auto note = [&rankById](int id, int rank) {
+        auto inserted = rankById.emplace(id, rank);
+        if (!inserted.second && rank < inserted.first->second) inserted.first->second = rank;
+    };
+
+    auto exact = m_byValue.find(locationValue);
+    if (exact != m_byValue.end()) {
+        for (int id : exact->second) note(id, 0);
+    }
+
+    UrlMatcher::ParsedUrl url = UrlMatcher::parse(locationValue);
+    if (url.valid) {
+        std::string hostKey = UrlMatcher::reversedHostKey(url.host);
+        std::string siteKeyBegin = UrlMatcher::reversedHostKey(url.registrableDomain);
+        std::string siteKeyEnd = siteKeyBegin;
+        siteKeyEnd.back() = '.' + 1;
+
+        auto it = std::lower_bound(m_byHost.begin(), m_byHost.end(), std::make_pair(siteKeyBegin, -1));
+        for (; it != m_byHost.end() && it->first < siteKeyEnd; ++it) {
+            auto row = m_rowById.find(it->second);
+            if (row == m_rowById.end() || !hasHostKey(row->second, it->first)) continue; // stale pair
+            note(it->second, it->first == hostKey ? 1 : 2);
+        }
+    }
+
+    std::vector<std::pair<int, int>> ranked;
+    ranked.reserve(rankById.size());
+    for (const auto& match : rankById) {
+        ranked.emplace_back(match.second, match.first);
+    }
+    std::sort(ranked.begin(), ranked.end());
+
+    std::vector<VaultEntry> entries;
+    for (const auto& match : ranked) {
+        size_t row = m_rowById.at(match.second);
+        if (url.valid && url.port != -1) {
+            // Same-site candidates that pin a different explicit port are different services
+            bool samePort = false;
+            for (uint32_t i = 0; i < m_locCount[row] && !samePort; ++i) {
+                const std::string& value = m_locValues[m_locFirst[row] + i];
+                samePort = value == locationValue || UrlMatcher::sameSite(UrlMatcher::parse(value), url);
+            }
+            if (!samePort) continue;
+        }
+        entries.push_back(materialize(row));
+    }
+    return entries;
+}
+
+std::vector<VaultEntry> MetadataIndex::searchEntries(const std::string& searchTerm) const {
+    std::string needle = searchNeedle(searchTerm);
+    bool searchNotes = searchesNotes(needle);
+
+    std::vector<std::pair<int, int>> ranked;
+    if (needle.empty()) {
+        for (size_t row = 0; row < m_ids.size(); ++row) {
+            ranked.emplace_back(TITLE, m_ids[row]);
+        }
+    } else {
+        size_t pos = 0;
+        auto segment = m_textSegments.begin();
+        while ((pos = m_text.find(needle, pos)) != std::string::npos) {
+            segment = std::upper_bound(segment, m_textSegments.end(), std::make_pair(pos, INT32_MAX)) - 1;
+            auto next = segment + 1;
+            size_t segmentEnd = next == m_textSegments.end() ? m_text.size() : next->first;
+            // Fields are laid out in rank order, so the first match in a
+            // segment is the entry's best one; skip the rest of it
+            if (segment->second != -1) {
+                size_t row = m_rowById.at(segment->second);
+                int field = fieldAt(row, pos - segment->first);
+                if (field != NOTES || searchNotes) {
+                    ranked.emplace_back(field, segment->second);
+                }
+            }
+            pos = segmentEnd;
+        }
+    }
+    return materializeRanked(ranked);
+}
+
+std::vector<VaultEntry> MetadataIndex::searchEntries(const std::string& searchTerm, const std::vector<int>& withinIds) const {
+    std::string needle = searchNeedle(searchTerm);
+    bool searchNotes = searchesNotes(needle);
+
+    std::vector<std::pair<int, int>> ranked;
+    for (int id : withinIds) {
+        auto found = m_rowById.find(id);
+        if (found == m_rowById.end()) {
+            continue;
+        }
+        size_t row = found->second;
+        std::string_view segment(m_text.data() + m_textOffset[row], textLength(row));
+        size_t pos = segment.find(needle);
+        if (pos == std::string_view::npos) {
+            continue;
+        }
+        int field = fieldAt(row, pos);
+        if (field != NOTES || searchNotes) {
+            ranked.emplace_back(field, id);
+        }
+    }
+    return materializeRanked(ranked);
+}
+
+bool MetadataIndex::narrows(const std::string& previous, const std::string& refined) {
+    std::string previousNeedle = searchNeedle(previous);
+    std::string refinedNeedle = searchNeedle(refined);
+    if (refinedNeedle.find(previousNeedle) == std::string::npos) {
+        return false;
+    }
+    // Going from 2 to 3 characters starts matching notes, which the previous results did not cover
+    return searchesNotes(previousNeedle) || !searchesNotes(refinedNeedle);
+}
+
+std::vector<VaultEntry> MetadataIndex::materializeRanked(std::vector<std::pair<int, int>>& ranked) const {
+    std::sort(ranked.begin(), ranked.end());
+
+    std::vector<VaultEntry> entries;
+    entries.reserve(ranked.size());
+    for (const auto& match : ranked) {
+        entries.push_back(materialize(m_rowById.at(match.second)));
+    }
+    return entries;
+}
+
+bool MetadataIndex::entryExists(const std::string& username, const std::string& locationValue) const {
+    auto found = m_byValue.find(locationValue);
+    if (found == m_byValue.end()) {
+        return false;
+    }
+    for (int id : found->second) {
+        if (m_usernames[m_rowById.at(id)] == username) return true;
+    }
+    return false;
+}
+
+MetadataIndexStats MetadataIndex::getStats() const {
+    return { m_ids.size(), m_locIds.size() - m_deadLocations, m_text.size() };
+}
+
+}
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "vault_entry.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace CipherMesh {
+namespace Core {
+
+struct MetadataIndexStats {
+    size_t entries;
+    size_t locations;
+    size_t textBytes;   // size of the search text arena, including dead space
+};
+
+// In-memory copy of entry metadata (everything except passwords) for an
+// unlocked vault, so listing, search and URL lookup need no SQLite round-trip.
+//
+// Layout is struct-of-arrays: one column per field, row r describing one
+// entry, and the locations of row r stored contiguously in the location
+// columns. Lookups go through:
+//  - a hash of exact location values,
+//  - a sorted (host key, entry id) array, where a registrable domain is a key
+//    prefix range (same keys as Database: "com.github.gist."),
+//  - one lowercased text arena holding title, username, locations and notes
+//    of every entry back to back, scanned with a single find() per search.
+// Removed rows are swapped with the last row; their location slots, host
+// pairs and text are left as dead space and compacted once they dominate.
+class MetadataIndex {
+public:
+    MetadataIndex();
+
+    // Drops every entry and releases the memory
+    void clear();
+    bool isReady() const { return m_ready; }
+    // Ends the initial bulk load: sorts the host index and the per-group
+    // entry order, which from then on are kept sorted by every mutation so
+    // lookups never write
+    void setReady();
+    // Changes whenever an entry is added, replaced or removed
+    unsigned long long revision() const { return m_revision; }
+
+    // 'entry' as stored (ids and timestamps filled in); replaces an entry with the same id
+    void addEntry(int groupId, const VaultEntry& entry);
+    // addEntry for many entries, re-sorting the host index once at the end
+    void addEntries(int groupId, const std::vector<VaultEntry>& entries);
+    bool removeEntry(int entryId);
+    void removeGroup(int groupId);
+    void setLastAccessed(int entryId, long long timestamp);
+
+    // Same results as the Database queries of the same name. Search matches
+    // title, username and locations (and notes for terms of 3+ characters),
+    // ASCII case-insensitively, and ranks title > username > location > notes.
+    std::vector<VaultEntry> getEntriesForGroup(int groupId) const;
+    // The first 'limit' entries of the group that sort after (afterTitle,
+    // afterId): a binary search into the group's order, so every page costs
+    // the same however deep
+    std::vector<VaultEntry> getEntriesForGroup(int groupId, const std::string& afterTitle, int afterId, size_t limit) const;
+    std::vector<VaultEntry> findEntriesByLocation(const std::string& locationValue) const;
+    std::vector<VaultEntry> searchEntries(const std::string& searchTerm) const;
+    // searchEntries restricted to the given entries; ids no longer indexed are skipped
+    std::vector<VaultEntry> searchEntries(const std::string& searchTerm, const std::vector<int>& withinIds) const;
+    bool entryExists(const std::string& username, const std::string& locationValue) const;
+    bool containsEntry(int entryId) const { return m_rowById.count(entryId) != 0; }
+    const std::vector<int>& entryIds() const { return m_ids; }
+    // Precondition: containsEntry(entryId)
+    VaultEntry getEntry(int entryId) const { return materialize(m_rowById.at(entryId)); }
+    // Precondition: containsEntry(entryId)
+    int getGroupId(int entryId) const { return m_groupIds[m_rowById.at(entryId)]; }
+
+    MetadataIndexStats getStats() const;
+
+    // True if every match for 'refined' is also a match for 'previous', so
+    // the refined search only needs to look at the previous results
+    static bool narrows(const std::string& previous, const std::string& refined);
+
+private:
+    bool m_ready;
+    unsigned long long m_revision;
+
+    // Entry columns
+    std::vector<int> m_ids;
+    std::vector<int> m_groupIds;
+    std::vector<std::string> m_titles;
+    std::vector<std::string> m_usernames;
+    std::vector<std::string> m_notes;
+    std::vector<long long> m_createdAt;
+    std::vector<long long> m_lastModified;
+    std::vector<long long> m_lastAccessed;
+    std::vector<long long> m_passwordExpiry;
+    std::vector<uint32_t> m_locFirst;   // first slot in the location columns
+    std::vector<uint32_t> m_locCount;
+    std::vector<size_t> m_textOffset;   // start of the row's segment in m_text
+    std::unordered_map<int, size_t> m_rowById;
+    // Entry ids of each group in getEntriesForGroup order, (title, id);
+    // appended unsorted during the bulk load
+    std::unordered_map<int, std::vector<int>> m_groupOrder;
+
+    // Location columns
+    std::vector<int> m_locIds;
+    std::vector<std::string> m_locTypes;
+    std::vector<std::string> m_locValues;
+    std::vector<std::string> m_locHostKeys;
+    size_t m_deadLocations;
+
+    std::unordered_map<std::string, std::vector<int>> m_byValue;
+    // Sorted once ready (appended unsorted during the bulk load). May hold
+    // pairs of removed/changed entries; validated on lookup
+    std::vector<std::pair<std::string, int>> m_byHost;
+    size_t m_staleHostPairs;
+
+    // Segments are "title\0username\0location\0...notes\0" in appended order;
+    // dead segments are zeroed and have entry id -1
+    std::string m_text;
+    std::vector<std::pair<size_t, int>> m_textSegments;
+    size_t m_deadText;
+
+    size_t textLength(size_t row) const;
+    int fieldAt(size_t row, size_t offsetInSegment) const;
+    void appendText(size_t row);
+    void appendLocations(size_t row, const std::vector<Location>& locations);
+    bool hasHostKey(size_t row, const std::string& hostKey) const;
+    VaultEntry materialize(size_t row) const;
+    bool entryBefore(int entryId, const std::string& title, int id) const;
+    bool entryBefore(int a, int b) const;
+    void insertIntoGroupOrder(size_t row);
+    void eraseFromGroupOrder(size_t row);
+    std::vector<VaultEntry> materializeRanked(std::vector<std::pair<int, int>>& ranked) const;
+    void compactLocations();
+    void compactText();
+    void rebuildHostIndex();
+};
+
+}
+}
@@ -0,0 +1,168 @@
+#include <sodium.h>
+#include "secure_buffer.hpp"
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+
+namespace CipherMesh {
+namespace Core {
+
+namespace {
+
+// Hands out SLOT_SIZE-byte slots from sodium_malloc'd pages. Pages are kept
+// for the life of the process and reused, so steady-state key handling does
+// not allocate. Once MAX_PAGES are in use, callers fall back to a dedicated
+// sodium_malloc allocation.
+class SecurePool {
+public:
+    static const size_t PAGE_SIZE = 4096;
+    static const size_t SLOTS_PER_PAGE = PAGE_SIZE / SecureBuffer::SLOT_SIZE;
+    static const size_t MAX_PAGES = 16;
+
+    static SecurePool& instance() {
+        // Never destroyed, so buffers in static objects can still be released at exit
+        static SecurePool* pool = new SecurePool();
+        return *pool;
+    }
+
+    unsigned char* acquire() {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (m_freeSlots.empty()) {
+            if (m_pages.size() >= MAX_PAGES) return nullptr;
+            unsigned char* page = static_cast<unsigned char*>(sodium_malloc(PAGE_SIZE));
+            if (!page) return nullptr;
+            m_pages.push_back(page);
+            for (size_t i = SLOTS_PER_PAGE; i > 0; --i) {
+                m_freeSlots.push_back(page + (i - 1) * SecureBuffer::SLOT_SIZE);
+            }
+        }
+        unsigned char* slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        ++m_slotsInUse;
+        return slot;
+    }
+
+    bool owns(const unsigned char* ptr) const {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        for (unsigned char* page : m_pages) {
+            if (ptr >= page && ptr < page + PAGE_SIZE) return true;
+        }
+        return false;
+    }
+
+    void release(unsigned char* slot) {
+        sodium_memzero(slot, SecureBuffer::SLOT_SIZE);
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_freeSlots.push_back(slot);
+        --m_slotsInUse;
+    }
+
+    void countLarge(int delta) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_largeAllocations += delta;
+    }
+
+    SecureBufferPoolStats stats() const {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        return SecureBufferPoolStats{ m_pages.size(), m_slotsInUse, m_largeAllocations };
+    }
+
+private:
+    SecurePool() : m_slotsInUse(0), m_largeAllocations(0) {
+        if (sodium_init() < 0) {
+            throw std::runtime_error("libsodium initialization failed!");
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    std::vector<unsigned char*> m_pages;
+    std::vector<unsigned char*> m_freeSlots;
+    size_t m_slotsInUse;
+    size_t m_largeAllocations;
+};
+
+unsigned char* secureAllocate(size_t size) {
+    SecurePool& pool = SecurePool::instance();
+    if (size <= SecureBuffer::SLOT_SIZE) {
+        if (unsigned char* slot = pool.acquire()) {
+            return slot;
+        }
+    }
+    unsigned char* ptr = static_cast<unsigned char*>(sodium_malloc(size));
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    pool.countLarge(1);
+    return ptr;
+}
+
+void secureRelease(unsigned char* ptr) {
+    SecurePool& pool = SecurePool::instance();
+    if (pool.owns(ptr)) {
+        pool.release(ptr);
+    } else {
+        // sodium_free() zeroes the allocation itself
+        sodium_free(ptr);
+        pool.countLarge(-1);
+    }
+}
+
+}
+
+SecureBuffer::SecureBuffer(size_t size) : m_data(nullptr), m_size(0) {
+    if (size > 0) {
+        m_data = secureAllocate(size);
+        m_size = size;
+        sodium_memzero(m_data, m_size);
+    }
+}
+
+SecureBuffer::SecureBuffer(const unsigned char* data, size_t size) : SecureBuffer(size) {
+    if (size > 0) {
+        std::copy(data, data + size, m_data);
+    }
+}
+
+SecureBuffer::~SecureBuffer() {
+    wipe();
+}
+
+SecureBuffer::SecureBuffer(SecureBuffer&& other) noexcept : m_data(other.m_data), m_size(other.m_size) {
+    other.m_data = nullptr;
+    other.m_size = 0;
+}
+
+SecureBuffer& SecureBuffer::operator=(SecureBuffer&& other) noexcept {
+    if (this != &other) {
+        wipe();
+        m_data = other.m_data;
+        m_size = other.m_size;
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+    return *this;
+}
+
+void SecureBuffer::wipe() {
+    if (m_data) {
+        secureRelease(m_data);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+SecureBuffer SecureBuffer::clone() const {
+    return SecureBuffer(m_data, m_size);
+}
+
+std::vector<unsigned char> SecureBuffer::toVector() const {
+    return std::vector<unsigned char>(begin(), end());
+}
+
+SecureBufferPoolStats SecureBuffer::getPoolStats() {
+    return SecurePool::instance().stats();
+}
+
+}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace CipherMesh {
+namespace Core {
+
+struct SecureBufferPoolStats {
+    size_t pages;            // sodium_malloc'd pool pages currently held
+    size_t slotsInUse;       // small buffers currently handed out from the pool
+    size_t largeAllocations; // live buffers too big for a pool slot (own sodium_malloc)
+};
+
+// Move-only byte buffer for key material. Buffers of up to SLOT_SIZE bytes
+// (keys, wrapped keys) are carved from a small pool of sodium_malloc'd pages,
+// which are mlock'ed and guard-paged; larger buffers get their own
+// sodium_malloc allocation. The contents are zeroed on destruction, on
+// wipe() and when a buffer is moved over. Copies must be made explicitly
+// with clone() or toVector().
+class SecureBuffer {
+public:
+    static const size_t SLOT_SIZE = 64;
+
+    SecureBuffer() noexcept : m_data(nullptr), m_size(0) {}
+    explicit SecureBuffer(size_t size);                  // zero-filled
+    SecureBuffer(const unsigned char* data, size_t size);
+    ~SecureBuffer();
+
+    SecureBuffer(SecureBuffer&& other) noexcept;
+    SecureBuffer& operator=(SecureBuffer&& other) noexcept;
+    SecureBuffer(const SecureBuffer&) = delete;
+    SecureBuffer& operator=(const SecureBuffer&) = delete;
+
+    unsigned char* data() { return m_data; }
+    const unsigned char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    unsigned char* begin() { return m_data; }
+    unsigned char* end() { return m_data + m_size; }
+    const unsigned char* begin() const { return m_data; }
+    const unsigned char* end() const { return m_data + m_size; }
+
+    // Zeroes and releases the memory; the buffer becomes empty
+    void wipe();
+
+    SecureBuffer clone() const;
+    // Plain copy for APIs outside the core (e.g. the P2P wire format); the
+    // caller is responsible for wiping it
+    std::vector<unsigned char> toVector() const;
+
+    static SecureBufferPoolStats getPoolStats();
+
+private:
+    unsigned char* m_data;
+    size_t m_size;
+};
+
+}
+}
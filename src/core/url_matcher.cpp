@@ -0,0 +1,144 @@
+#include "url_matcher.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace CipherMesh {
+namespace Core {
+
+namespace {
+
+std::string toLower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+bool isIpAddress(const std::string& host) {
+    if (host.find(':') != std::string::npos) return true; // IPv6
+    return !host.empty() && std::all_of(host.begin(), host.end(), [](unsigned char c) { return std::isdigit(c) || c == '.'; });
+}
+
+// Multi-label public suffixes under which every label is a separate site.
+// Not the full Public Suffix List, just the ones common enough to matter.
+const char* const kMultiLabelSuffixes[] = {
+    "co.uk", "org.uk", "ac.uk", "gov.uk", "me.uk", "ltd.uk", "plc.uk",
+    "com.au", "net.au", "org.au", "edu.au", "gov.au",
+    "co.nz", "org.nz", "co.jp", "ne.jp", "or.jp", "co.kr", "or.kr",
+    "com.br", "com.cn", "net.cn", "org.cn", "com.mx", "com.tr", "com.sg",
+    "co.in", "co.za", "co.il", "com.ar", "com.tw", "com.hk",
+    "github.io", "gitlab.io", "herokuapp.com", "blogspot.com", "appspot.com",
+    "azurewebsites.net", "cloudfront.net", "netlify.app", "vercel.app", "pages.dev",
+};
+
+std::string registrableDomainOf(const std::string& host) {
+    if (isIpAddress(host)) return host;
+    size_t last = host.rfind('.');
+    if (last == std::string::npos) return host; // "localhost", intranet names
+    size_t second = host.rfind('.', last - 1);
+    if (second == std::string::npos || last == 0) return host;
+    std::string lastTwo = host.substr(second + 1);
+    for (const char* suffix : kMultiLabelSuffixes) {
+        if (lastTwo == suffix) {
+            size_t third = second == 0 ? std::string::npos : host.rfind('.', second - 1);
+            return third == std::string::npos ? host : host.substr(third + 1);
+        }
+    }
+    return lastTwo;
+}
+
+}
+
+UrlMatcher::ParsedUrl UrlMatcher::parse(const std::string& value) {
+    ParsedUrl url;
+
+    size_t begin = value.find_first_not_of(" \t\r\n");
+    size_t end = value.find_last_not_of(" \t\r\n");
+    if (begin == std::string::npos) return url;
+    std::string s = value.substr(begin, end - begin + 1);
+
+    size_t rest = 0;
+    size_t schemeEnd = s.find("://");
+    if (schemeEnd != std::string::npos) {
+        url.scheme = toLower(s.substr(0, schemeEnd));
+        rest = schemeEnd + 3;
+    }
+
+    size_t authorityEnd = s.find_first_of("/?#", rest);
+    std::string authority = s.substr(rest, authorityEnd == std::string::npos ? std::string::npos : authorityEnd - rest);
+    if (authorityEnd != std::string::npos && s[authorityEnd] == '/') {
+        size_t pathEnd = s.find_first_of("?#", authorityEnd);
+        url.path = s.substr(authorityEnd, pathEnd == std::string::npos ? std::string::npos : pathEnd - authorityEnd);
+    }
+
+    size_t at = authority.rfind('@');
+    if (at != std::string::npos) authority = authority.substr(at + 1);
+
+    std::string host = authority;
+    if (!authority.empty() && authority[0] == '[') {
+        size_t close = authority.find(']');
+        if (close == std::string::npos) return url;
+        host = authority.substr(1, close - 1);
+        if (close + 1 < authority.size() && authority[close + 1] == ':') {
+            std::string port = authority.substr(close + 2);
+            if (!port.empty() && std::all_of(port.begin(), port.end(), ::isdigit)) url.port = std::stoi(port.substr(0, 5));
+        }
+    } else {
+        size_t colon = authority.rfind(':');
+        if (colon != std::string::npos) {
+            std::string port = authority.substr(colon + 1);
+            if (port.empty() || !std::all_of(port.begin(), port.end(), ::isdigit)) return url;
+            url.port = std::stoi(port.substr(0, 5));
+            host = authority.substr(0, colon);
+        }
+    }
+
+    host = toLower(host);
+    while (!host.empty() && host.back() == '.') host.pop_back();
+    if (host.empty()) return url;
+    for (unsigned char c : host) {
+        if (!(std::isalnum(c) || c == '.' || c == '-' || c == '_' || c == ':' || c >= 0x80)) return url;
+    }
+    // Without a scheme, only accept things that look like a hostname
+    if (url.scheme.empty() && host.find('.') == std::string::npos && host != "localhost") return url;
+
+    url.host = host;
+    url.registrableDomain = registrableDomainOf(host);
+    url.valid = true;
+    return url;
+}
+
+std::string UrlMatcher::reversedHostKey(const std::string& host) {
+    std::string key;
+    key.reserve(host.size() + 1);
+    size_t end = host.size();
+    while (true) {
+        size_t dot = host.rfind('.', end == 0 ? 0 : end - 1);
+        if (dot == std::string::npos || end == 0) {
+            key.append(host, 0, end);
+            key += '.';
+            break;
+        }
+        key.append(host, dot + 1, end - dot - 1);
+        key += '.';
+        end = dot;
+    }
+    return key;
+}
+
+std::string UrlMatcher::hostKeyForLocation(const std::string& type, const std::string& value) {
+    std::string lowerType = toLower(type);
+    ParsedUrl url = parse(value);
+    if (!url.valid) return "";
+    bool webType = lowerType == "url" || lowerType == "website";
+    bool webScheme = url.scheme == "http" || url.scheme == "https";
+    if (!webType && !webScheme) return "";
+    return reversedHostKey(url.host);
+}
+
+bool UrlMatcher::sameSite(const ParsedUrl& a, const ParsedUrl& b) {
+    if (!a.valid || !b.valid || a.registrableDomain != b.registrableDomain) return false;
+    if (a.port != -1 && b.port != -1 && a.port != b.port) return false;
+    return true;
+}
+
+}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+namespace CipherMesh {
+namespace Core {
+
+// URL normalization used to match stored locations against page URLs by site
+// rather than by substring. Hosts are indexed by a reversed-label key such as
+// "com.github.gist." so that everything under one registrable domain shares a
+// key prefix ("com.github.") and can be found with an index range scan.
+class UrlMatcher {
+public:
+    struct ParsedUrl {
+        bool valid = false;
+        std::string scheme;             // lowercase, empty if the value had none
+        std::string host;               // lowercase, without trailing dot or brackets
+        int port = -1;                  // -1 if not given explicitly
+        std::string path;               // starts with '/', empty if none
+        std::string registrableDomain;  // e.g. "example.co.uk" for "login.example.co.uk"
+    };
+
+    static ParsedUrl parse(const std::string& value);
+
+    // "gist.github.com" -> "com.github.gist."
+    static std::string reversedHostKey(const std::string& host);
+
+    // Host key stored with a location, or empty if the location is not a web address
+    static std::string hostKeyForLocation(const std::string& type, const std::string& value);
+
+    // True if both URLs belong to the same registrable domain and, when both
+    // name an explicit port, the ports agree
+    static bool sameSite(const ParsedUrl& a, const ParsedUrl& b);
+};
+
+}
+}
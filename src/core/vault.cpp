@@ -2,15 +2,70 @@
 #include "vault.hpp"
 #include "database.hpp"
 #include "crypto.hpp"
+#include <algorithm>
+#include <chrono>
+#include <exception>
 #include <stdexcept>
 #include <iostream>
+#include <thread>
+#include <unordered_set>
+#include <ctime>
 
 namespace CipherMesh {
 namespace Core {
 
 const std::string KEY_CANARY = "CIPHERMESH_OK";
+const int DEFAULT_KDF_TARGET_MS = 500;
+const char* const DEFAULT_THEME_ID = "professional";
+const int DEFAULT_AUTO_LOCK_MINUTES = 15;
+const long long ACCESS_FLUSH_INTERVAL_SECONDS = 60;
+// An index refresh re-reads entries modified this long before the previous
+// sync too, covering writers whose transaction was still open at that sync
+const long long INDEX_REFRESH_SLACK_SECONDS = 60;
+// Below this many blobs per thread, starting another worker costs more than it saves
+const size_t MIN_BLOBS_PER_REENCRYPT_THREAD = 512;
+
+// Re-encrypts each blob in place from 'oldKey' to 'newKey' (fresh nonce,
+// same length), split into contiguous ranges across up to one thread per
+// core. Returns the number of threads used; rethrows the first failure.
+static unsigned reencryptBlobs(const std::vector<std::vector<unsigned char>*>& blobs,
+                               const SecureBuffer& oldKey, const SecureBuffer& newKey) {
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    size_t threads = std::min(cores, std::max<size_t>(1, blobs.size() / MIN_BLOBS_PER_REENCRYPT_THREAD));
+    std::vector<std::exception_ptr> errors(threads);
+    auto work = [&](size_t t) {
+        try {
+            size_t begin = blobs.size() * t / threads;
+            size_t end = blobs.size() * (t + 1) / threads;
+            size_t longest = 1;
+            for (size_t i = begin; i < end; ++i) {
+                longest = std::max(longest, Crypto::plaintextSize(blobs[i]->size()));
+            }
+            SecureBuffer plaintext(longest);
+            for (size_t i = begin; i < end; ++i) {
+                std::vector<unsigned char>& blob = *blobs[i];
+                size_t length = Crypto::decrypt(blob.data(), blob.size(), oldKey, plaintext.data(), plaintext.size());
+                Crypto::encrypt(plaintext.data(), length, newKey, blob.data(), blob.size());
+            }
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; ++t) {
+        workers.emplace_back(work, t);
+    }
+    work(0);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    for (const std::exception_ptr& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    return static_cast<unsigned>(threads);
+}
 
-Vault::Vault() : m_activeGroupId(-1) {
+Vault::Vault() : m_activeGroupId(-1), m_kdfTargetMs(DEFAULT_KDF_TARGET_MS), m_groupKeysVersion(-1), m_metadataIndex(std::make_shared<MetadataIndex>()), m_metadataIndexEnabled(true), m_metadataIndexVersion(0), m_metadataIndexSyncTime(0), m_metadataIndexMaxId(0), m_settingsLoaded(false) {
     if (sodium_init() < 0) {
         throw std::runtime_error("libsodium initialization failed!");
     }
@@ -27,59 +82,176 @@ Vault::~Vault() {
 }
 
 bool Vault::createNewVault(const std::string& path, const std::string& masterPassword) {
+    return create(path, masterPassword, nullptr, nullptr) == UnlockResult::Unlocked;
+}
+
+UnlockHandle Vault::createNewVaultAsync(const std::string& path, const std::string& masterPassword,
+                                        UnlockProgressCallback onProgress, UnlockCompletionCallback onComplete) {
+    return runAsync(&Vault::create, path, masterPassword, std::move(onProgress), std::move(onComplete));
+}
+
+UnlockResult Vault::create(const std::string& path, const std::string& masterPassword,
+                           const std::atomic<bool>* cancelled, const UnlockProgressCallback& onProgress) {
+    auto report = [&onProgress](UnlockStage stage) { if (onProgress) onProgress(stage); };
+    auto isCancelled = [cancelled]() { return cancelled && cancelled->load(); };
     try {
+        report(UnlockStage::OpeningVault);
+        // Lock first: it writes pending access times to the old file
+        lock();
         // Close existing database if open
         if (m_db) {
             m_db->close();
         }
-        lock();
         m_dbPath = path; 
-        m_db->open(path);
+        m_db->open(path, m_storageOptions);
+        // Calibration and Argon2 take seconds: run them before taking the
+        // write lock so other connections are not held past their busy timeout
+        report(UnlockStage::CalibratingKdf);
+        KdfParams params = m_crypto->calibrateKdf(m_kdfTargetMs);
+        if (isCancelled()) {
+            return UnlockResult::Cancelled;
+        }
+        report(UnlockStage::DerivingKey);
+        DerivedMasterKey masterKey = deriveMasterKey(masterPassword, params);
+        if (isCancelled()) {
+            return UnlockResult::Cancelled;
+        }
+        // Schema, key material and the Personal group commit together
+        Transaction txn(*m_db);
         m_db->createTables();
-        std::vector<unsigned char> salt = m_crypto->randomBytes(m_crypto->SALT_SIZE);
-        m_masterKey_RAM = m_crypto->deriveKey(masterPassword, salt);
-        m_db->storeMetadata("argon_salt", salt);
-        std::vector<unsigned char> canary_blob = m_crypto->encrypt(KEY_CANARY, m_masterKey_RAM);
-        m_db->storeMetadata("key_canary", canary_blob);
+        replaceMasterKey(std::move(masterKey), nullptr);
         addGroup("Personal");
-        return true;
+        txn.commit();
+        report(UnlockStage::Finished);
+        return UnlockResult::Unlocked;
     } catch (const std::exception& e) {
         std::cerr << "Failed to create vault: " << e.what() << std::endl;
         lock();
-        return false;
+        return UnlockResult::Failed;
     }
 }
 
 bool Vault::loadVault(const std::string& path, const std::string& masterPassword) {
+    return unlock(path, masterPassword, nullptr, nullptr) == UnlockResult::Unlocked;
+}
+
+UnlockHandle Vault::loadVaultAsync(const std::string& path, const std::string& masterPassword,
+                                   UnlockProgressCallback onProgress, UnlockCompletionCallback onComplete) {
+    return runAsync(&Vault::unlock, path, masterPassword, std::move(onProgress), std::move(onComplete));
+}
+
+// Runs 'job' (unlock or create) on a worker thread with its own copy of the
+// password, wiped when the job is done
+UnlockHandle Vault::runAsync(OpenJob job, const std::string& path, const std::string& masterPassword,
+                             UnlockProgressCallback onProgress, UnlockCompletionCallback onComplete) {
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    std::shared_future<UnlockResult> result = std::async(std::launch::async,
+        [this, job, path, password = std::string(masterPassword), cancelled, onProgress, onComplete]() mutable {
+            UnlockResult outcome = (this->*job)(path, password, cancelled.get(), onProgress);
+            m_crypto->secureWipe(password);
+            if (onComplete) {
+                try {
+                    onComplete(outcome);
+                } catch (const std::exception& e) {
+                    // Keep the outcome intact for whoever waits on the handle
+                    std::cerr << "Vault open completion callback failed: " << e.what() << std::endl;
+                }
+            }
+            return outcome;
+        }).share();
+    return UnlockHandle(result, cancelled);
+}
+
+UnlockResult Vault::unlock(const std::string& path, const std::string& masterPassword,
+                           const std::atomic<bool>* cancelled, const UnlockProgressCallback& onProgress) {
+    auto report = [&onProgress](UnlockStage stage) { if (onProgress) onProgress(stage); };
+    auto isCancelled = [cancelled]() { return cancelled && cancelled->load(); };
     try {
+        report(UnlockStage::OpeningVault);
+        // Lock first: it writes pending access times to the old file
+        lock();
         // Close existing database if open
         if (m_db) {
             m_db->close();
         }
-        lock();
         m_dbPath = path; 
-        m_db->open(path);
+        m_db->open(path, m_storageOptions);
         m_db->createTables(); // Ensure tables exist
+        bool kdfStored = false;
+        KdfParams kdf = loadKdfParams(kdfStored);
         std::vector<unsigned char> salt = m_db->getMetadata("argon_salt");
-        m_masterKey_RAM = m_crypto->deriveKey(masterPassword, salt);
         std::vector<unsigned char> canary_blob = m_db->getMetadata("key_canary");
-        std::string decrypted_canary = m_crypto->decryptToString(canary_blob, m_masterKey_RAM);
+        if (isCancelled()) {
+            return UnlockResult::Cancelled;
+        }
+
+        report(UnlockStage::DerivingKey);
+        m_masterKey_RAM = m_crypto->deriveKey(masterPassword, salt, kdf);
+        if (isCancelled()) {
+            lock();
+            return UnlockResult::Cancelled;
+        }
+
+        report(UnlockStage::VerifyingKey);
+        std::string decrypted_canary;
+        try {
+            decrypted_canary = m_crypto->decryptToString(canary_blob, m_masterKey_RAM);
+        } catch (const std::exception&) {
+            // Authentication failure: the key came from a wrong password
+        }
         if (decrypted_canary != KEY_CANARY) {
             lock();
-            return false;
+            return UnlockResult::WrongPassword;
         }
-        return true;
+        // Vaults from before KDF calibration: move them to calibrated,
+        // recorded parameters now that we have the password
+        if (!kdfStored && !isCancelled()) {
+            report(UnlockStage::UpgradingKdf);
+            try {
+                rekeyMaster(masterPassword, m_crypto->calibrateKdf(m_kdfTargetMs));
+            } catch (const std::exception& e) {
+                std::cerr << "KDF upgrade skipped: " << e.what() << std::endl;
+            }
+        }
+        if (isCancelled()) {
+            lock();
+            return UnlockResult::Cancelled;
+        }
+        settings();
+        if (m_metadataIndexEnabled) {
+            report(UnlockStage::LoadingIndex);
+            metadataIndexReady();
+        }
+        report(UnlockStage::Finished);
+        return UnlockResult::Unlocked;
     } catch (const std::exception& e) {
+        std::cerr << "Failed to unlock vault: " << e.what() << std::endl;
         lock();
-        return false;
+        return UnlockResult::Failed;
     }
 }
 
 void Vault::lock() {
+    try {
+        flushAccessTimes();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to save entry access times: " << e.what() << std::endl;
+    }
+    m_accessLog.clear();
     m_crypto->secureWipe(m_masterKey_RAM);
     m_crypto->secureWipe(m_activeGroupKey_RAM);
+    m_groupKeyCache.clear();
+    m_wrappedGroupKeys.clear();
+    m_groupKeysVersion = -1;
+    resetMetadataIndex();
+    m_settingsLoaded = false;
+    m_groupAccess.clear();
     m_activeGroupId = -1;
     m_activeGroupName = "";
+    // Idle point: move committed WAL pages into the main file
+    if (m_db) {
+        m_db->checkpoint();
+    }
     // NOTE: We keep m_dbPath and don't close the database
     // This allows verifyMasterPassword() to work even when locked
     // The database will be closed when a new vault is loaded or the Vault object is destroyed
@@ -105,47 +277,184 @@ bool Vault::verifyMasterPassword(const std::string& password) {
     }
     
     try {
-        std::vector<unsigned char> salt = m_db->getMetadata("argon_salt");
-        std::vector<unsigned char> tempKey = m_crypto->deriveKey(password, salt);
-        std::vector<unsigned char> canary_blob = m_db->getMetadata("key_canary");
-        std::string decrypted_canary = m_crypto->decryptToString(canary_blob, tempKey);
-        m_crypto->secureWipe(tempKey); 
-        return (decrypted_canary == KEY_CANARY);
+        bool kdfStored = false;
+        KdfParams kdf = loadKdfParams(kdfStored);
+        return passwordMatches(password, m_db->getMetadata("argon_salt"), kdf, m_db->getMetadata("key_canary"));
     } catch (...) {
         return false; 
     }
 }
 
-bool Vault::changeMasterPassword(const std::string& newPassword) {
+// Whether the key 'password' derives to opens the key canary
+bool Vault::passwordMatches(const std::string& password, const std::vector<unsigned char>& salt,
+                            const KdfParams& params, const std::vector<unsigned char>& canary) {
+    SecureBuffer key = Crypto::deriveKey(password, salt, params);
+    try {
+        return Crypto::decryptToString(canary, key) == KEY_CANARY;
+    } catch (const std::exception&) {
+        return false; // authentication failure: wrong key
+    }
+}
+
+bool Vault::changeMasterPassword(const std::string& newPassword, const RekeyProgressCallback& onProgress) {
     checkLocked(); 
     try {
-        std::vector<unsigned char> newSalt = m_crypto->randomBytes(m_crypto->SALT_SIZE);
-        std::vector<unsigned char> newMasterKey = m_crypto->deriveKey(newPassword, newSalt);
-        std::map<int, std::vector<unsigned char>> oldGroupKeys = m_db->getAllEncryptedGroupKeys();
-        
-        for (auto const& [groupId, oldEncryptedKey] : oldGroupKeys) {
-            std::vector<unsigned char> groupKey = m_crypto->decrypt(oldEncryptedKey, m_masterKey_RAM);
-            std::vector<unsigned char> newEncryptedKey = m_crypto->encrypt(groupKey, newMasterKey);
-            m_db->updateEncryptedGroupKey(groupId, newEncryptedKey);
-            m_crypto->secureWipe(groupKey);
-        }
+        bool kdfStored = false;
+        KdfParams params = loadKdfParams(kdfStored);
+        if (onProgress) onProgress(RekeyStage::DerivingKey, 0, 0);
+        replaceMasterKey(deriveMasterKey(newPassword, params), onProgress);
+        // Group keys themselves are unchanged, so the active group stays usable
+        return true;
+    } catch (...) {
+        return false; 
+    }
+}
 
-        std::vector<unsigned char> new_canary_blob = m_crypto->encrypt(KEY_CANARY, newMasterKey);
-        m_db->storeMetadata("key_canary", new_canary_blob);
-        m_db->storeMetadata("argon_salt", newSalt);
-        
-        m_crypto->secureWipe(m_masterKey_RAM);
-        m_masterKey_RAM = std::move(newMasterKey);
-        
-        if (isGroupActive()) {
-            setActiveGroup(m_activeGroupName);
+std::future<DerivedMasterKey> Vault::deriveMasterKeyAsync(const std::string& currentPassword, const std::string& newPassword,
+                                                          std::function<void(DeriveResult)> onDone) {
+    checkLocked();
+    bool kdfStored = false;
+    KdfParams params = loadKdfParams(kdfStored);
+    std::vector<unsigned char> salt = m_db->getMetadata("argon_salt");
+    std::vector<unsigned char> canary = m_db->getMetadata("key_canary");
+    return std::async(std::launch::async, [current = std::string(currentPassword), password = std::string(newPassword),
+                                           params, salt, canary, onDone]() mutable {
+        DerivedMasterKey derived;
+        DeriveResult result = DeriveResult::Derived;
+        std::exception_ptr error;
+        try {
+            if (passwordMatches(current, salt, params, canary)) {
+                derived = deriveMasterKey(password, params);
+            } else {
+                result = DeriveResult::WrongPassword;
+                error = std::make_exception_ptr(std::runtime_error("Current master password is incorrect."));
+            }
+        } catch (...) {
+            result = DeriveResult::Failed;
+            error = std::current_exception();
         }
+        Crypto::secureWipe(current);
+        Crypto::secureWipe(password);
+        if (onDone) {
+            try {
+                onDone(result);
+            } catch (const std::exception& e) {
+                std::cerr << "Key derivation callback failed: " << e.what() << std::endl;
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return derived;
+    });
+}
+
+bool Vault::changeMasterPassword(DerivedMasterKey newKey, const RekeyProgressCallback& onProgress) {
+    checkLocked();
+    try {
+        replaceMasterKey(std::move(newKey), onProgress);
         return true;
     } catch (...) {
-        return false; 
+        return false;
     }
 }
 
+KdfParams Vault::getKdfParams() {
+    bool stored = false;
+    return loadKdfParams(stored);
+}
+
+// Parameters recorded in vault_metadata; vaults created before they were
+// recorded used the KdfParams defaults
+KdfParams Vault::loadKdfParams(bool& stored) {
+    KdfParams params;
+    stored = false;
+    std::vector<unsigned char> algorithm, opsLimit, memLimit;
+    try {
+        algorithm = m_db->getMetadata("kdf_algorithm");
+        opsLimit = m_db->getMetadata("kdf_opslimit");
+        memLimit = m_db->getMetadata("kdf_memlimit");
+    } catch (const DBException&) {
+        return params;
+    }
+    params.algorithm = std::stoi(std::string(algorithm.begin(), algorithm.end()));
+    params.opsLimit = std::stoull(std::string(opsLimit.begin(), opsLimit.end()));
+    params.memLimit = static_cast<size_t>(std::stoull(std::string(memLimit.begin(), memLimit.end())));
+    if ((params.algorithm != crypto_pwhash_ALG_ARGON2ID13 && params.algorithm != crypto_pwhash_ALG_ARGON2I13) ||
+        params.opsLimit < crypto_pwhash_OPSLIMIT_MIN || params.memLimit < crypto_pwhash_MEMLIMIT_MIN) {
+        throw std::runtime_error("Invalid KDF parameters in vault metadata.");
+    }
+    stored = true;
+    return params;
+}
+
+DerivedMasterKey Vault::deriveMasterKey(const std::string& password, const KdfParams& params) {
+    DerivedMasterKey derived;
+    derived.salt = Crypto::randomBytes(Crypto::SALT_SIZE);
+    derived.key = Crypto::deriveKey(password, derived.salt, params);
+    derived.params = params;
+    return derived;
+}
+
+// Derives a new master key (fresh salt, given parameters) and installs it
+// with replaceMasterKey
+void Vault::rekeyMaster(const std::string& password, const KdfParams& params) {
+    replaceMasterKey(deriveMasterKey(password, params), nullptr);
+}
+
+// Re-wraps every group key with the new master key and writes keys, salt,
+// canary and KDF parameters in one transaction, opened before the group keys
+// are read so a group added or re-keyed by another connection meanwhile
+// cannot be overwritten or left wrapped under the old master key. The
+// in-memory master key is replaced only after that write succeeds; inside an
+// enclosing Transaction the write is not durable until the caller commits,
+// so a caller that can still roll back must lock() on failure, as
+// createNewVault does.
+void Vault::replaceMasterKey(DerivedMasterKey newKey, const RekeyProgressCallback& onProgress) {
+    auto report = [&onProgress](RekeyStage stage, size_t done, size_t total) {
+        if (onProgress) onProgress(stage, done, total);
+    };
+    const SecureBuffer& newMasterKey = newKey.key;
+
+    Transaction txn(*m_db);
+    std::map<int, std::vector<unsigned char>> groupKeys;
+    if (!m_masterKey_RAM.empty()) {
+        groupKeys = m_db->getAllEncryptedGroupKeys();
+        // Re-wrap every group key through one reused buffer
+        SecureBuffer groupKey(Crypto::KEY_SIZE);
+        size_t done = 0;
+        report(RekeyStage::RewrappingKeys, done, groupKeys.size());
+        for (auto& [groupId, encryptedKey] : groupKeys) {
+            size_t keySize = Crypto::decrypt(encryptedKey.data(), encryptedKey.size(), m_masterKey_RAM, groupKey.data(), groupKey.size());
+            if (keySize != Crypto::KEY_SIZE) {
+                throw std::runtime_error("Invalid group key size.");
+            }
+            encryptedKey = m_crypto->encrypt(groupKey, newMasterKey);
+            report(RekeyStage::RewrappingKeys, ++done, groupKeys.size());
+        }
+    }
+
+    const KdfParams& params = newKey.params;
+    auto text = [](const std::string& value) { return std::vector<unsigned char>(value.begin(), value.end()); };
+    std::map<std::string, std::vector<unsigned char>> metadata;
+    metadata["argon_salt"] = newKey.salt;
+    metadata["key_canary"] = m_crypto->encrypt(KEY_CANARY, newMasterKey);
+    metadata["kdf_algorithm"] = text(std::to_string(params.algorithm));
+    metadata["kdf_opslimit"] = text(std::to_string(params.opsLimit));
+    metadata["kdf_memlimit"] = text(std::to_string(params.memLimit));
+    report(RekeyStage::Committing, 0, 0);
+    m_db->replaceKeyMaterial(groupKeys, metadata);
+    txn.commit();
+
+    m_masterKey_RAM = std::move(newKey.key);
+    m_groupKeyCache.clear();
+    m_wrappedGroupKeys.clear();
+    if (isGroupActive()) {
+        m_wrappedGroupKeys[m_activeGroupId] = groupKeys[m_activeGroupId];
+    }
+    report(RekeyStage::Finished, 0, 0);
+}
+
 std::vector<std::string> Vault::getGroupNames() {
     checkLocked();
     return m_db->getAllGroupNames();
@@ -164,18 +473,20 @@ bool Vault::groupExists(const std::string& groupName) {
 bool Vault::addGroup(const std::string& groupName) {
     checkLocked();
     try {
-        std::vector<unsigned char> newGroupKey = m_crypto->randomBytes(m_crypto->KEY_SIZE);
+        SecureBuffer newGroupKey = m_crypto->generateKey();
         std::vector<unsigned char> encryptedGroupKey = m_crypto->encrypt(newGroupKey, m_masterKey_RAM);
         
         std::string ownerId = getUserId();
         if(ownerId.empty()) ownerId = "me";
         
+        m_groupAccess.erase(groupName);
+        Transaction txn(*m_db);
         m_db->storeEncryptedGroup(groupName, encryptedGroupKey, ownerId);
-        m_crypto->secureWipe(newGroupKey);
         
         // Add self as owner
         int gid = m_db->getGroupId(groupName);
         m_db->addGroupMember(gid, ownerId, "owner", "accepted");
+        txn.commit();
         
         return true;
     } catch (const std::exception& e) {
@@ -191,11 +502,14 @@ bool Vault::addGroup(const std::string& groupName, const std::vector<unsigned ch
         std::string ownerId = getUserId(); 
         if(ownerId.empty()) ownerId = "me";
 
+        m_groupAccess.erase(groupName);
+        Transaction txn(*m_db);
         m_db->storeEncryptedGroup(groupName, encryptedGroupKey, ownerId);
         
         // Add self as admin (since we accepted a share)
         int gid = m_db->getGroupId(groupName);
         m_db->addGroupMember(gid, ownerId, "admin", "accepted");
+        txn.commit();
 
         return true;
     } catch (...) {
@@ -203,23 +517,74 @@ bool Vault::addGroup(const std::string& groupName, const std::vector<unsigned ch
     }
 }
 
+GroupKeyRotationStats Vault::rotateGroupKey(const std::string& groupName) {
+    checkLocked();
+    auto started = std::chrono::steady_clock::now();
+    int groupId = m_db->getGroupId(groupName);
+
+    // Read the key and blobs inside the write transaction so no other
+    // connection can rotate the key or add a blob under it before the new
+    // one is in place. The old key is unwrapped from the file, not taken
+    // from memory, which may predate a rotation by another process.
+    Transaction txn(*m_db);
+    SecureBuffer oldKey = m_crypto->decrypt(m_db->getEncryptedGroupKeyById(groupId), m_masterKey_RAM);
+    SecureBuffer newKey = m_crypto->generateKey();
+    std::vector<EncryptedPasswordRow> passwords = m_db->getEncryptedPasswordsForGroup(groupId);
+    std::vector<EncryptedPasswordRow> history = m_db->getEncryptedPasswordHistoryForGroup(groupId);
+    std::vector<std::vector<unsigned char>*> blobs;
+    blobs.reserve(passwords.size() + history.size());
+    for (EncryptedPasswordRow& row : passwords) blobs.push_back(&row.encryptedPassword);
+    for (EncryptedPasswordRow& row : history) blobs.push_back(&row.encryptedPassword);
+    unsigned threads = reencryptBlobs(blobs, oldKey, newKey);
+
+    std::vector<unsigned char> wrappedKey = m_crypto->encrypt(newKey, m_masterKey_RAM);
+    m_db->updateEncryptedGroupKey(groupId, wrappedKey);
+    m_db->updateEncryptedPasswords(passwords);
+    m_db->updateEncryptedPasswordHistory(history);
+    txn.commit();
+
+    m_groupKeyCache.erase(groupId);
+    if (groupId == m_activeGroupId) {
+        m_activeGroupKey_RAM = std::move(newKey);
+        m_wrappedGroupKeys[groupId] = std::move(wrappedKey);
+    } else {
+        m_wrappedGroupKeys.erase(groupId);
+    }
+
+    GroupKeyRotationStats stats;
+    stats.entries = passwords.size();
+    stats.historyEntries = history.size();
+    stats.threads = threads;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    stats.entriesPerSecond = stats.seconds > 0 ? stats.entries / stats.seconds : 0;
+    return stats;
+}
+
 bool Vault::setActiveGroup(const std::string& groupName) {
     checkLocked();
-    lockActiveGroup();
+    releaseActiveGroup();
     try {
         int groupId = -1;
         std::vector<unsigned char> encryptedKey = m_db->getEncryptedGroupKey(groupName, groupId);
         m_activeGroupKey_RAM = m_crypto->decrypt(encryptedKey, m_masterKey_RAM);
         m_activeGroupId = groupId;
         m_activeGroupName = groupName;
+        m_wrappedGroupKeys[groupId] = std::move(encryptedKey);
         return true;
     } catch (const std::exception& e) {
-        lockActiveGroup();
+        releaseActiveGroup();
         return false;
     }
 }
 
 void Vault::lockActiveGroup() {
+    releaseActiveGroup();
+    m_groupKeyCache.clear();
+    m_wrappedGroupKeys.clear();
+}
+
+// Switching groups only drops the active key; cached keys stay until a real lock
+void Vault::releaseActiveGroup() {
     m_crypto->secureWipe(m_activeGroupKey_RAM);
     m_activeGroupId = -1;
     m_activeGroupName = "";
@@ -235,7 +600,16 @@ bool Vault::deleteGroup(const std::string& groupName) {
         if (groupName == m_activeGroupName) {
             lockActiveGroup();
         }
-        return m_db->deleteGroup(groupName);
+        int groupId = m_db->getGroupId(groupName);
+        m_groupKeyCache.erase(groupId);
+        m_wrappedGroupKeys.erase(groupId);
+        m_groupAccess.erase(groupName);
+        m_accessLog.removeGroup(groupId);
+        bool deleted = m_db->deleteGroup(groupName);
+        if (deleted && m_metadataIndex->isReady()) {
+            mutableMetadataIndex().removeGroup(groupId);
+        }
+        return deleted;
     } catch (const std::exception& e) {
         return false;
     }
@@ -250,15 +624,46 @@ void Vault::checkGroupActive() const {
 
 std::vector<VaultEntry> Vault::getEntries() {
     checkGroupActive();
+    if (metadataIndexReady()) {
+        return m_metadataIndex->getEntriesForGroup(m_activeGroupId);
+    }
     return m_db->getEntriesForGroup(m_activeGroupId);
 }
 
+EntryPage Vault::getEntriesPage(int limit, const std::string& pageToken) {
+    checkGroupActive();
+    if (!metadataIndexReady()) {
+        return m_db->getEntriesForGroupPage(m_activeGroupId, limit, pageToken);
+    }
+    std::string afterTitle;
+    int afterId = 0;
+    Database::decodePageRequest(limit, pageToken, afterTitle, afterId);
+    return Database::makeEntryPage(m_metadataIndex->getEntriesForGroup(m_activeGroupId, afterTitle, afterId, limit + 1), limit);
+}
+
+VaultEntry Vault::getEntry(int entryId) {
+    checkLocked();
+    if (metadataIndexReady() && m_metadataIndex->containsEntry(entryId)) {
+        return m_metadataIndex->getEntry(entryId);
+    }
+    return m_db->getEntry(entryId);
+}
+
 bool Vault::addEntry(const VaultEntry& entry, const std::string& password) {
     checkGroupActive();
     try {
         VaultEntry tempEntry = entry; 
+        // Encrypt under the key current inside the write transaction, so a
+        // rotation by another process cannot leave the blob under a dead key
+        Transaction txn(*m_db);
+        refreshGroupKeys();
+        checkGroupActive();
         std::vector<unsigned char> encryptedPassword = m_crypto->encrypt(password, m_activeGroupKey_RAM);
         m_db->storeEntry(m_activeGroupId, tempEntry, encryptedPassword);
+        txn.commit();
+        if (m_metadataIndex->isReady()) {
+            mutableMetadataIndex().addEntry(m_activeGroupId, tempEntry);
+        }
         return true;
     } catch (const std::exception& e) {
         return false;
@@ -268,7 +673,12 @@ bool Vault::addEntry(const VaultEntry& entry, const std::string& password) {
 bool Vault::deleteEntry(int entryId) {
     checkGroupActive();
     try {
-        return m_db->deleteEntry(entryId);
+        bool deleted = m_db->deleteEntry(entryId);
+        if (deleted) {
+            mutableMetadataIndex().removeEntry(entryId);
+            m_accessLog.removeEntry(entryId);
+        }
+        return deleted;
     } catch (const std::exception& e) {
         return false;
     }
@@ -278,11 +688,17 @@ bool Vault::updateEntry(const VaultEntry& entry, const std::string& newPassword)
     checkGroupActive();
     try {
         if (!newPassword.empty()) {
+            // As in addEntry: encrypt under the key current in the transaction
+            Transaction txn(*m_db);
+            refreshGroupKeys();
+            checkGroupActive();
             std::vector<unsigned char> encryptedPassword = m_crypto->encrypt(newPassword, m_activeGroupKey_RAM);
             m_db->updateEntry(entry, &encryptedPassword);
+            txn.commit();
         } else {
             m_db->updateEntry(entry, nullptr); 
         }
+        reindexEntry(entry.id);
         return true;
     } catch (const std::exception& e) {
         return false;
@@ -291,102 +707,272 @@ bool Vault::updateEntry(const VaultEntry& entry, const std::string& newPassword)
 
 std::string Vault::getDecryptedPassword(int entryId) {
     checkLocked(); 
-    int groupId = m_db->getGroupIdForEntry(entryId);
-    std::vector<unsigned char> encryptedGroupKey = m_db->getEncryptedGroupKeyById(groupId);
-    std::vector<unsigned char> groupKey = m_crypto->decrypt(encryptedGroupKey, m_masterKey_RAM);
-    std::vector<unsigned char> encryptedPassword = m_db->getEncryptedPassword(entryId);
-    std::string decryptedPassword = m_crypto->decryptToString(encryptedPassword, groupKey);
-    m_crypto->secureWipe(groupKey);
-    return decryptedPassword;
+    int groupId = -1;
+    std::vector<unsigned char> encryptedPassword = m_db->getEncryptedPassword(entryId, groupId);
+    SecureBuffer groupKey = unwrapGroupKey(groupId);
+    return m_crypto->decryptToString(encryptedPassword, groupKey);
 }
 
 bool Vault::entryExists(const std::string& username, const std::string& locationValue) {
     checkLocked();
+    if (metadataIndexReady()) {
+        return m_metadataIndex->entryExists(username, locationValue);
+    }
     return m_db->entryExists(username, locationValue);
 }
 
 std::vector<VaultEntry> Vault::findEntriesByLocation(const std::string& locationValue) {
     checkLocked();
+    if (metadataIndexReady()) {
+        return m_metadataIndex->findEntriesByLocation(locationValue);
+    }
     return m_db->findEntriesByLocation(locationValue);
 }
 
 std::vector<VaultEntry> Vault::searchEntries(const std::string& searchTerm) {
     checkLocked();
+    if (metadataIndexReady()) {
+        return m_metadataIndex->searchEntries(searchTerm);
+    }
     return m_db->searchEntries(searchTerm);
 }
 
-std::vector<unsigned char> Vault::getGroupKey(const std::string& groupName) {
+void Vault::setMetadataIndexEnabled(bool enabled) {
+    m_metadataIndexEnabled = enabled;
+    if (!enabled) {
+        resetMetadataIndex();
+    }
+}
+
+// Loads every entry's metadata; the data version is read first so that a
+// write by another process during the load causes a rebuild, never a miss
+void Vault::buildMetadataIndex() {
+    resetMetadataIndex();
+    m_metadataIndexVersion = m_db->getDataVersion();
+    m_metadataIndexSyncTime = std::time(nullptr);
+    m_metadataIndexMaxId = 0;
+    for (const std::string& groupName : m_db->getAllGroupNames()) {
+        int groupId = m_db->getGroupId(groupName);
+        for (const VaultEntry& entry : m_db->getEntriesForGroup(groupId)) {
+            mutableMetadataIndex().addEntry(groupId, entry);
+            m_metadataIndexMaxId = std::max(m_metadataIndexMaxId, entry.id);
+        }
+    }
+    mutableMetadataIndex().setReady();
+}
+
+// Merges in what another connection committed since the last sync: one scan
+// of entry ids finds deletions, and only entries with a new id or a recent
+// last_modified are re-read. As in buildMetadataIndex, the data version is
+// read first so a commit racing with this triggers another refresh.
+void Vault::refreshMetadataIndex() {
+    long long version = m_db->getDataVersion();
+    long long syncTime = std::time(nullptr);
+
+    std::vector<int> ids = m_db->getEntryIds();
+    std::unordered_set<int> live(ids.begin(), ids.end());
+    std::vector<int> removed;
+    for (int entryId : m_metadataIndex->entryIds()) {
+        if (!live.count(entryId)) removed.push_back(entryId);
+    }
+    for (int entryId : removed) {
+        mutableMetadataIndex().removeEntry(entryId);
+    }
+
+    std::unordered_map<int, std::vector<VaultEntry>> changedByGroup;
+    for (VaultEntry& entry : m_db->getEntriesChangedSince(m_metadataIndexSyncTime - INDEX_REFRESH_SLACK_SECONDS, m_metadataIndexMaxId)) {
+        auto pending = m_accessLog.pending().find(entry.id);
+        if (pending != m_accessLog.pending().end()) {
+            entry.lastAccessed = pending->second;
+        }
+        try {
+            changedByGroup[m_db->getGroupIdForEntry(entry.id)].push_back(std::move(entry));
+        } catch (const DBException&) {
+            // Deleted in the meantime; the next refresh drops it
+        }
+    }
+    for (const auto& [groupId, entries] : changedByGroup) {
+        mutableMetadataIndex().addEntries(groupId, entries);
+    }
+
+    m_metadataIndexVersion = version;
+    m_metadataIndexSyncTime = syncTime;
+    for (int entryId : ids) {
+        m_metadataIndexMaxId = std::max(m_metadataIndexMaxId, entryId);
+    }
+}
+
+// True if reads can be served from the index, (re)building it when needed
+bool Vault::metadataIndexReady() {
+    if (!m_metadataIndexEnabled || isLocked()) {
+        return false;
+    }
+    try {
+        if (m_metadataIndex->isReady() && m_db->getDataVersion() != m_metadataIndexVersion) {
+            refreshMetadataIndex();
+        }
+        if (!m_metadataIndex->isReady()) {
+            buildMetadataIndex();
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Metadata index unavailable: " << e.what() << std::endl;
+        resetMetadataIndex();
+        return false;
+    }
+}
+
+std::shared_ptr<const MetadataIndex> Vault::getMetadataIndexSnapshot() {
     checkLocked();
-    if (isGroupActive() && m_activeGroupName == groupName) {
-        return m_activeGroupKey_RAM;
+    if (!metadataIndexReady()) {
+        return nullptr;
     }
-    int groupId = -1;
-    std::vector<unsigned char> encryptedKey = m_db->getEncryptedGroupKey(groupName, groupId);
-    return m_crypto->decrypt(encryptedKey, m_masterKey_RAM);
+    return m_metadataIndex;
+}
+
+// Copy-on-write: snapshots handed out keep seeing the index as it was
+MetadataIndex& Vault::mutableMetadataIndex() {
+    if (m_metadataIndex.use_count() > 1) {
+        m_metadataIndex = std::make_shared<MetadataIndex>(*m_metadataIndex);
+    }
+    return *m_metadataIndex;
+}
+
+void Vault::resetMetadataIndex() {
+    if (m_metadataIndex.use_count() > 1) {
+        m_metadataIndex = std::make_shared<MetadataIndex>();
+    } else {
+        m_metadataIndex->clear();
+    }
+}
+
+// Re-reads one entry after an update (new location ids, last_modified)
+void Vault::reindexEntry(int entryId) {
+    if (!m_metadataIndex->isReady()) {
+        return;
+    }
+    try {
+        VaultEntry entry = m_db->getEntry(entryId);
+        auto pending = m_accessLog.pending().find(entryId);
+        if (pending != m_accessLog.pending().end()) {
+            entry.lastAccessed = pending->second;
+        }
+        mutableMetadataIndex().addEntry(m_db->getGroupIdForEntry(entryId), entry);
+    } catch (const std::exception&) {
+        // Rebuilt on the next read
+        resetMetadataIndex();
+    }
+}
+
+SecureBuffer Vault::getGroupKey(const std::string& groupName) {
+    checkLocked();
+    return unwrapGroupKey(m_db->getGroupId(groupName));
+}
+
+// The active key, a cached key, or the key freshly unwrapped with the master key
+SecureBuffer Vault::unwrapGroupKey(int groupId) {
+    refreshGroupKeys();
+    if (isGroupActive() && m_activeGroupId == groupId) {
+        return m_activeGroupKey_RAM.clone();
+    }
+    SecureBuffer groupKey;
+    if (!m_groupKeyCache.lookup(groupId, groupKey)) {
+        std::vector<unsigned char> encryptedGroupKey = m_db->getEncryptedGroupKeyById(groupId);
+        groupKey = m_crypto->decrypt(encryptedGroupKey, m_masterKey_RAM);
+        m_groupKeyCache.insert(groupId, groupKey);
+        m_wrappedGroupKeys[groupId] = std::move(encryptedGroupKey);
+    }
+    return groupKey;
+}
+
+// Another connection (e.g. vault-service on the same file) may have rotated
+// or deleted a group since its key was unwrapped here. data_version moves
+// only on other connections' commits; when it has, compare each wrapped key
+// with the one ours came from and evict only those that changed. The active
+// key is re-read, or the group deactivated if it is gone. Run it before using
+// a key, inside the write transaction when encrypting.
+void Vault::refreshGroupKeys() {
+    long long version = m_db->getDataVersion();
+    if (version == m_groupKeysVersion) {
+        return;
+    }
+    std::map<int, std::vector<unsigned char>> current = m_db->getAllEncryptedGroupKeys();
+    for (auto it = m_wrappedGroupKeys.begin(); it != m_wrappedGroupKeys.end();) {
+        auto found = current.find(it->first);
+        if (found != current.end() && found->second == it->second) {
+            ++it;
+            continue;
+        }
+        m_groupKeyCache.erase(it->first);
+        if (isGroupActive() && it->first == m_activeGroupId) {
+            if (found == current.end()) {
+                releaseActiveGroup();
+            } else {
+                m_activeGroupKey_RAM = m_crypto->decrypt(found->second, m_masterKey_RAM);
+                it->second = found->second;
+                ++it;
+                continue;
+            }
+        }
+        it = m_wrappedGroupKeys.erase(it);
+    }
+    m_groupKeysVersion = version;
 }
 
 std::vector<VaultEntry> Vault::exportGroupEntries(const std::string& groupName) {
     checkLocked();
     int groupId = m_db->getGroupId(groupName);
     
-    std::vector<unsigned char> groupKey;
-    if (isGroupActive() && m_activeGroupName == groupName) {
-        groupKey = m_activeGroupKey_RAM;
-    } else {
-        std::vector<unsigned char> encKey = m_db->getEncryptedGroupKeyById(groupId);
-        groupKey = m_crypto->decrypt(encKey, m_masterKey_RAM);
-    }
-    
-    std::vector<VaultEntry> entries = m_db->getEntriesForGroup(groupId);
-    for (auto& entry : entries) {
-        std::vector<unsigned char> encPass = m_db->getEncryptedPassword(entry.id);
-        entry.password = m_crypto->decryptToString(encPass, groupKey);
-    }
+    SecureBuffer groupKey = unwrapGroupKey(groupId);
     
-    if (!isGroupActive() || m_activeGroupName != groupName) {
-        m_crypto->secureWipe(groupKey);
+    std::vector<std::vector<unsigned char>> encryptedPasswords;
+    std::vector<VaultEntry> entries = m_db->getEntriesWithPasswordsForGroup(groupId, encryptedPasswords);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        // Decrypt in place into the entry's password string
+        const std::vector<unsigned char>& blob = encryptedPasswords[i];
+        std::string& password = entries[i].password;
+        password.resize(Crypto::plaintextSize(blob.size()));
+        Crypto::decrypt(blob.data(), blob.size(), groupKey, reinterpret_cast<unsigned char*>(&password[0]), password.size());
     }
     
     return entries;
 }
 
-void Vault::importGroupEntries(const std::string& groupName, const std::vector<VaultEntry>& entries) {
+void Vault::importGroupEntries(const std::string& groupName, std::vector<VaultEntry> entries) {
     checkLocked();
     int groupId = m_db->getGroupId(groupName);
     
-    std::vector<unsigned char> groupKey;
-    if (isGroupActive() && m_activeGroupName == groupName) {
-        groupKey = m_activeGroupKey_RAM;
-    } else {
-        std::vector<unsigned char> encKey = m_db->getEncryptedGroupKeyById(groupId);
-        groupKey = m_crypto->decrypt(encKey, m_masterKey_RAM);
-    }
+    // Encrypt and store under one write transaction (see addEntry)
+    Transaction txn(*m_db);
+    SecureBuffer groupKey = unwrapGroupKey(groupId);
     
-    for (auto entry : entries) {
-        std::vector<unsigned char> encPass = m_crypto->encrypt(entry.password, groupKey);
-        m_db->storeEntry(groupId, entry, encPass);
+    std::vector<std::vector<unsigned char>> encryptedPasswords;
+    encryptedPasswords.reserve(entries.size());
+    for (auto& entry : entries) {
+        // One exact-size allocation per entry; the nonce is written in place
+        std::vector<unsigned char>& blob = encryptedPasswords.emplace_back(Crypto::ciphertextSize(entry.password.size()));
+        Crypto::encrypt(reinterpret_cast<const unsigned char*>(entry.password.data()), entry.password.size(), groupKey, blob.data(), blob.size());
         m_crypto->secureWipe(entry.password); 
     }
+    groupKey.wipe();
     
-    if (!isGroupActive() || m_activeGroupName != groupName) {
-        m_crypto->secureWipe(groupKey);
+    m_db->storeEntries(groupId, entries, encryptedPasswords);
+    txn.commit();
+    if (m_metadataIndex->isReady()) {
+        mutableMetadataIndex().addEntries(groupId, entries);
     }
 }
 
 void Vault::setUserId(const std::string& userId) {
     checkLocked();
-    std::vector<unsigned char> idData(userId.begin(), userId.end());
-    m_db->storeMetadata("user_id", idData);
+    storeSetting("user_id", userId);
+    m_settings.userId = userId;
+    m_groupAccess.clear();
 }
 
 std::string Vault::getUserId() {
     checkLocked();
-    try {
-        std::vector<unsigned char> data = m_db->getMetadata("user_id");
-        return std::string(data.begin(), data.end());
-    } catch (...) {
-        return ""; 
-    }
+    return settings().userId;
 }
 
 void Vault::storePendingInvite(const std::string& senderId, const std::string& groupName, const std::string& payloadJson) {
@@ -418,6 +1004,7 @@ std::string Vault::getGroupOwner(int groupId) {
 
 void Vault::setGroupPermissions(int groupId, bool adminsOnly) {
     checkLocked();
+    invalidateGroupAccess(groupId);
     m_db->setGroupPermissions(groupId, adminsOnly);
 }
 
@@ -428,17 +1015,20 @@ GroupPermissions Vault::getGroupPermissions(int groupId) {
 
 void Vault::updateGroupMemberRole(int groupId, const std::string& userId, const std::string& newRole) {
     checkLocked();
+    invalidateGroupAccess(groupId);
     m_db->updateGroupMemberRole(groupId, userId, newRole);
 }
 
 void Vault::addGroupMember(const std::string& groupName, const std::string& userId, const std::string& role, const std::string& status) {
     checkLocked();
     int groupId = m_db->getGroupId(groupName);
+    m_groupAccess.erase(groupName);
     m_db->addGroupMember(groupId, userId, role, status);
 }
 
 void Vault::addGroupMember(int groupId, const std::string& userId, const std::string& role, const std::string& status) {
     checkLocked();
+    invalidateGroupAccess(groupId);
     m_db->addGroupMember(groupId, userId, role, status);
 }
 
@@ -451,12 +1041,14 @@ std::vector<GroupMember> Vault::getGroupMembers(const std::string& groupName) {
 void Vault::removeGroupMember(const std::string& groupName, const std::string& userId) {
     checkLocked();
     int groupId = m_db->getGroupId(groupName);
+    m_groupAccess.erase(groupName);
     m_db->removeGroupMember(groupId, userId);
 }
 
 void Vault::updateGroupMemberStatus(const std::string& groupName, const std::string& userId, const std::string& newStatus) {
     checkLocked();
     int groupId = m_db->getGroupId(groupName);
+    m_groupAccess.erase(groupName);
     m_db->updateGroupMemberStatus(groupId, userId, newStatus);
 }
 
@@ -464,31 +1056,19 @@ bool Vault::canUserEdit(const std::string& groupName) {
     checkLocked();
     
     try {
-        int groupId = m_db->getGroupId(groupName);
         std::string myId = getUserId();
         if (myId.empty()) return true;
 
-        if (m_db->getGroupOwner(groupId) == myId || m_db->getGroupOwner(groupId) == "me") {
+        const GroupAccess& access = groupAccess(groupName);
+        if (access.ownerId == myId || access.ownerId == "me") {
             return true;
         }
 
-        std::vector<GroupMember> members = m_db->getGroupMembers(groupId);
-        std::string myRole = "member";
-        bool found = false;
-        for(const auto& m : members) {
-            if(m.userId == myId) {
-                myRole = m.role;
-                found = true;
-                break;
-            }
-        }
-        
-        if (!found) return true; 
+        if (!access.isMember) return true; 
 
-        if (myRole == "owner" || myRole == "admin") return true;
+        if (access.myRole == "owner" || access.myRole == "admin") return true;
 
-        GroupPermissions perms = m_db->getGroupPermissions(groupId);
-        if (perms.adminsOnlyWrite) return false;
+        if (access.adminsOnlyWrite) return false;
 
         return true; 
     } catch (...) {
@@ -496,6 +1076,39 @@ bool Vault::canUserEdit(const std::string& groupName) {
     }
 }
 
+// Builds the group's snapshot on first use. A failed lookup throws and
+// leaves nothing cached.
+const GroupAccess& Vault::groupAccess(const std::string& groupName) {
+    auto it = m_groupAccess.find(groupName);
+    if (it != m_groupAccess.end()) {
+        return it->second;
+    }
+    const std::string& myId = settings().userId;
+    GroupAccess access;
+    access.groupId = m_db->getGroupId(groupName);
+    access.ownerId = m_db->getGroupOwner(access.groupId);
+    access.isMember = false;
+    for (const GroupMember& m : m_db->getGroupMembers(access.groupId)) {
+        if (m.userId == myId) {
+            access.isMember = true;
+            access.myRole = m.role;
+            break;
+        }
+    }
+    access.adminsOnlyWrite = m_db->getGroupPermissions(access.groupId).adminsOnlyWrite;
+    return m_groupAccess.emplace(groupName, std::move(access)).first->second;
+}
+
+void Vault::invalidateGroupAccess(int groupId) {
+    for (auto it = m_groupAccess.begin(); it != m_groupAccess.end();) {
+        if (it->second.groupId == groupId) {
+            it = m_groupAccess.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 void Vault::updatePendingInviteStatus(int inviteId, const std::string& status) {
     checkLocked();
     m_db->updatePendingInviteStatus(inviteId, status);
@@ -505,36 +1118,64 @@ void Vault::updatePendingInviteStatus(int inviteId, const std::string& status) {
 
 void Vault::setThemeId(const std::string& themeId) {
     checkLocked();
-    std::vector<unsigned char> data(themeId.begin(), themeId.end());
-    m_db->storeMetadata("app_theme", data);
+    storeSetting("app_theme", themeId);
+    m_settings.themeId = themeId;
 }
 
 std::string Vault::getThemeId() {
     checkLocked();
-    try {
-        std::vector<unsigned char> data = m_db->getMetadata("app_theme");
-        return std::string(data.begin(), data.end());
-    } catch (...) {
-        return "professional"; // Default if not set
-    }
+    return settings().themeId;
 }
 
 void Vault::setAutoLockTimeout(int minutes) {
     checkLocked();
-    std::string value = std::to_string(minutes);
-    std::vector<unsigned char> data(value.begin(), value.end());
-    m_db->storeMetadata("auto_lock_timeout", data);
+    storeSetting("auto_lock_timeout", std::to_string(minutes));
+    m_settings.autoLockTimeoutMinutes = minutes;
 }
 
 int Vault::getAutoLockTimeout() {
     checkLocked();
-    try {
-        std::vector<unsigned char> data = m_db->getMetadata("auto_lock_timeout");
-        std::string value(data.begin(), data.end());
-        return std::stoi(value);
-    } catch (...) {
-        return 15; // Default 15 minutes
+    return settings().autoLockTimeoutMinutes;
+}
+
+// Loads the cached settings on first use after unlock; unset or unreadable
+// values fall back to the defaults
+const VaultSettings& Vault::settings() {
+    if (m_settingsLoaded) {
+        return m_settings;
+    }
+    auto read = [this](const std::string& key, std::string& value) {
+        try {
+            std::vector<unsigned char> data = m_db->getMetadata(key);
+            value.assign(data.begin(), data.end());
+            return true;
+        } catch (...) {
+            return false;
+        }
+    };
+    VaultSettings loaded;
+    read("user_id", loaded.userId);
+    if (!read("app_theme", loaded.themeId)) {
+        loaded.themeId = DEFAULT_THEME_ID;
+    }
+    std::string timeout;
+    loaded.autoLockTimeoutMinutes = DEFAULT_AUTO_LOCK_MINUTES;
+    if (read("auto_lock_timeout", timeout)) {
+        try {
+            loaded.autoLockTimeoutMinutes = std::stoi(timeout);
+        } catch (...) {
+        }
     }
+    m_settings = loaded;
+    m_settingsLoaded = true;
+    return m_settings;
+}
+
+// Write-through: callers update m_settings only once this succeeded. Loads
+// first so that a later load cannot overwrite the updated field.
+void Vault::storeSetting(const std::string& key, const std::string& value) {
+    settings();
+    m_db->storeMetadata(key, std::vector<unsigned char>(value.begin(), value.end()));
 }
 
 std::vector<PasswordHistoryEntry> Vault::getPasswordHistory(int entryId) {
@@ -547,21 +1188,67 @@ std::string Vault::decryptPasswordFromHistory(const std::string& encryptedPasswo
     checkLocked();
     checkGroupActive();
     std::vector<unsigned char> encrypted(encryptedPassword.begin(), encryptedPassword.end());
-    std::vector<unsigned char> decrypted = m_crypto->decrypt(encrypted, m_activeGroupKey_RAM);
-    return std::string(decrypted.begin(), decrypted.end());
+    refreshGroupKeys();
+    checkGroupActive();
+    return m_crypto->decryptToString(encrypted, m_activeGroupKey_RAM);
 }
 
 void Vault::updateEntryAccessTime(int entryId) {
     checkLocked();
     checkGroupActive();
-    m_db->updateEntryAccessTime(entryId);
+    long long now = std::time(nullptr);
+    // Search results span groups: file the access under the entry's own group
+    int groupId = m_metadataIndex->isReady() && m_metadataIndex->containsEntry(entryId)
+        ? m_metadataIndex->getGroupId(entryId)
+        : m_db->getGroupIdForEntry(entryId);
+    loadRecentAccesses(groupId);
+    m_accessLog.record(groupId, entryId, now);
+    if (m_metadataIndex->isReady()) {
+        mutableMetadataIndex().setLastAccessed(entryId, now);
+    }
+    if (now - m_accessLog.oldestPending() >= ACCESS_FLUSH_INTERVAL_SECONDS) {
+        flushAccessTimes();
+    }
 }
 
 std::vector<VaultEntry> Vault::getRecentlyAccessedEntries(int limit) {
     checkLocked();
     checkGroupActive();
-    return m_db->getRecentlyAccessedEntries(m_activeGroupId, limit);
+    if (limit < 0 || static_cast<size_t>(limit) > EntryAccessLog::RECENT_CAPACITY) {
+        flushAccessTimes();
+        return m_db->getRecentlyAccessedEntries(m_activeGroupId, limit);
+    }
+    loadRecentAccesses(m_activeGroupId);
+    std::vector<VaultEntry> entries;
+    for (int entryId : m_accessLog.recent(m_activeGroupId, limit)) {
+        try {
+            entries.push_back(getEntry(entryId));
+        } catch (const DBException&) {
+            // Deleted by another process
+        }
+    }
+    return entries;
+}
+
+void Vault::flushAccessTimes() {
+    if (m_accessLog.pending().empty()) {
+        return;
+    }
+    m_db->updateEntryAccessTimes(m_accessLog.pending());
+    m_accessLog.clearPending();
 }
 
+// Seeds the group's recent list from the database once per unlock
+void Vault::loadRecentAccesses(int groupId) {
+    if (m_accessLog.hasRecent(groupId)) {
+        return;
+    }
+    std::vector<int> entryIds;
+    for (const VaultEntry& entry : m_db->getRecentlyAccessedEntries(groupId, EntryAccessLog::RECENT_CAPACITY)) {
+        entryIds.push_back(entry.id);
+    }
+    m_accessLog.loadRecent(groupId, entryIds);
+}
+
+}
 }
-}
\ No newline at end of file
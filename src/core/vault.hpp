@@ -1,9 +1,20 @@
 #pragma once
 
 #include "vault_entry.hpp"
+#include "database.hpp"
+#include "entry_access_log.hpp"
+#include "group_key_cache.hpp"
+#include "metadata_index.hpp"
+#include "secure_buffer.hpp"
+#include "crypto.hpp"
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
 
 namespace CipherMesh {
 namespace Core {
@@ -18,13 +29,100 @@ namespace Core {
 // REMOVED: Structs GroupMember and GroupPermissions
 // They are already defined in "vault_entry.hpp"
 
+// Settings stored in vault_metadata, with the defaults used when unset
+struct VaultSettings {
+    std::string userId;          // "" when not set
+    std::string themeId;         // "professional" when not set
+    int autoLockTimeoutMinutes;  // 15 when not set, 0 = never auto-lock
+};
+
+// What canUserEdit needs to know about one group
+struct GroupAccess {
+    int groupId;
+    std::string ownerId;
+    bool isMember;           // whether this user is in the member list
+    std::string myRole;      // "" when not a member
+    bool adminsOnlyWrite;
+};
+
+// CalibratingKdf is only reported when creating a vault
+enum class UnlockStage { OpeningVault, CalibratingKdf, DerivingKey, VerifyingKey, UpgradingKdf, LoadingIndex, Finished };
+enum class UnlockResult { Unlocked, WrongPassword, Cancelled, Failed };
+
+// Callbacks of an asynchronous unlock; both run on the worker thread
+using UnlockProgressCallback = std::function<void(UnlockStage)>;
+using UnlockCompletionCallback = std::function<void(UnlockResult)>;
+
+// Handle to an unlock running on a worker thread. Argon2 itself cannot be
+// interrupted: cancel() takes effect at the next stage boundary, after which
+// the derived key is wiped and the vault is left locked. Destroying the last
+// copy of the handle waits for the worker to finish.
+class UnlockHandle {
+public:
+    UnlockHandle() = default;
+    UnlockHandle(std::shared_future<UnlockResult> result, std::shared_ptr<std::atomic<bool>> cancelled)
+        : m_result(std::move(result)), m_cancelled(std::move(cancelled)) {}
+
+    bool isValid() const { return m_result.valid(); }
+    bool isFinished() const { return m_result.valid() && m_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+    void cancel() { if (m_cancelled) m_cancelled->store(true); }
+    UnlockResult wait() const { return m_result.get(); }
+
+private:
+    std::shared_future<UnlockResult> m_result;
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
+
+// Outcome of Vault::rotateGroupKey
+struct GroupKeyRotationStats {
+    size_t entries;           // entry passwords re-encrypted
+    size_t historyEntries;    // password history rows re-encrypted
+    unsigned threads;         // workers that shared the re-encryption
+    double seconds;           // whole rotation, commit included
+    double entriesPerSecond;  // entries / seconds
+};
+
+// Steps of a master password change (DerivingKey only when changeMasterPassword
+// derives the key itself). The re-wrapped keys, salt, canary and KDF
+// parameters are written in one transaction (Committing); until it has
+// committed the vault on disk and in memory still uses the old password.
+enum class RekeyStage { DerivingKey, RewrappingKeys, Committing, Finished };
+
+// 'done' of 'total' group keys re-wrapped so far (both 0 outside RewrappingKeys)
+using RekeyProgressCallback = std::function<void(RekeyStage stage, size_t done, size_t total)>;
+
+// Outcome of Vault::deriveMasterKeyAsync, passed to its callback
+enum class DeriveResult { Derived, WrongPassword, Failed };
+
+// Master key for a new password, derived ahead of the change (see
+// Vault::deriveMasterKeyAsync)
+struct DerivedMasterKey {
+    SecureBuffer key;
+    std::vector<unsigned char> salt;
+    KdfParams params;
+};
+
 class Vault {
 public:
     Vault();
     ~Vault();
 
+    // Storage settings (WAL, busy timeout/retries) used when the vault file is opened
+    void setStorageOptions(const StorageOptions& options) { m_storageOptions = options; }
+
     bool createNewVault(const std::string& path, const std::string& masterPassword);
     bool loadVault(const std::string& path, const std::string& masterPassword);
+    // Runs loadVault on a worker thread. The vault must not be used by anyone
+    // else until the handle reports it finished (or onComplete has run).
+    UnlockHandle loadVaultAsync(const std::string& path, const std::string& masterPassword,
+                                UnlockProgressCallback onProgress = nullptr,
+                                UnlockCompletionCallback onComplete = nullptr);
+    // Runs createNewVault on a worker thread under the same rules; KDF
+    // calibration and derivation take a second or more. The result is
+    // Unlocked, Cancelled or Failed.
+    UnlockHandle createNewVaultAsync(const std::string& path, const std::string& masterPassword,
+                                     UnlockProgressCallback onProgress = nullptr,
+                                     UnlockCompletionCallback onComplete = nullptr);
     
     // Locks the vault by wiping encryption keys from memory
     // NOTE: Database remains open to allow password verification
@@ -34,7 +132,24 @@ public:
     // Verify master password - works even when vault is locked
     // This allows browser extensions to authenticate before performing operations
     bool verifyMasterPassword(const std::string& password);
-    bool changeMasterPassword(const std::string& newPassword);
+    bool changeMasterPassword(const std::string& newPassword, const RekeyProgressCallback& onProgress = nullptr);
+    // The slow half of a password change: reads the KDF parameters, salt and
+    // canary, then on a worker thread that touches no Vault state checks
+    // 'currentPassword' against them and runs Argon2 for the new password
+    // with a fresh salt, so the vault stays usable meanwhile. onDone runs on
+    // the worker just before it returns; the future then holds the key, or
+    // throws for WrongPassword and Failed.
+    std::future<DerivedMasterKey> deriveMasterKeyAsync(const std::string& currentPassword, const std::string& newPassword,
+                                                       std::function<void(DeriveResult)> onDone = nullptr);
+    // The fast half: re-wraps every group key and commits them with the new
+    // salt, canary and KDF parameters in one transaction. No KDF runs here.
+    bool changeMasterPassword(DerivedMasterKey newKey, const RekeyProgressCallback& onProgress = nullptr);
+
+    // Target unlock time used to calibrate the KDF for new vaults and when an
+    // older vault without stored KDF parameters is re-keyed on unlock.
+    // 0 skips calibration and uses the fixed interactive parameters.
+    void setKdfTargetMs(int targetMs) { m_kdfTargetMs = targetMs; }
+    KdfParams getKdfParams();
 
     std::vector<std::string> getGroupNames();
     
@@ -43,6 +158,14 @@ public:
     bool addGroup(const std::string& groupName);
     bool addGroup(const std::string& groupName, const std::vector<unsigned char>& key);
     bool groupExists(const std::string& groupName);
+    // Replaces the group's key with a fresh one: every entry password and
+    // password history blob is re-encrypted on a pool of worker threads and
+    // the result is committed together with the new wrapped key in one
+    // transaction. Throws (leaving the group unchanged) on failure. Members
+    // this group is shared with still hold the old key until it is re-shared;
+    // other processes on the same file pick the new key up on their next
+    // use (see refreshGroupKeys).
+    GroupKeyRotationStats rotateGroupKey(const std::string& groupName);
     
     // -- Permissions & Roles --
     std::string getGroupOwner(int groupId); 
@@ -66,7 +189,13 @@ public:
     bool deleteGroup(const std::string& groupName);
 
     std::vector<VaultEntry> getEntries();
+    // The active group's entries one page at a time, in getEntries order;
+    // see Database::getEntriesForGroupPage
+    EntryPage getEntriesPage(int limit, const std::string& pageToken = "");
+    // Metadata of a single entry in any group (no password); throws if it does not exist
+    VaultEntry getEntry(int entryId);
     bool addEntry(const VaultEntry& entry, const std::string& password);
+    // Uses a per-session cache of unwrapped group keys (see getGroupKeyCacheStats)
     std::string getDecryptedPassword(int entryId);
     bool deleteEntry(int entryId);
     bool updateEntry(const VaultEntry& entry, const std::string& newPassword);
@@ -76,9 +205,10 @@ public:
     std::vector<VaultEntry> searchEntries(const std::string& searchTerm); 
 
     // -- P2P / Sync Helpers --
-    std::vector<unsigned char> getGroupKey(const std::string& groupName);
+    SecureBuffer getGroupKey(const std::string& groupName);
     std::vector<VaultEntry> exportGroupEntries(const std::string& groupName);
-    void importGroupEntries(const std::string& groupName, const std::vector<VaultEntry>& entries);
+    // Takes the entries by value: pass an rvalue to move them in without a copy
+    void importGroupEntries(const std::string& groupName, std::vector<VaultEntry> entries);
 
     void storePendingInvite(const std::string& senderId, const std::string& groupName, const std::string& payloadJson);
     std::vector<PendingInvite> getPendingInvites();
@@ -87,6 +217,9 @@ public:
     void setUserId(const std::string& userId);
     std::string getUserId();
     
+    // Answered from a per-group snapshot of owner, own role and permissions,
+    // built on first use and dropped by the member, role and permission
+    // setters of that group (all of them on setUserId and lock)
     bool canUserEdit(const std::string& groupName);
     // ... (existing public methods) ...
     
@@ -97,26 +230,102 @@ public:
     // --- Auto-lock Settings ---
     void setAutoLockTimeout(int minutes); // 0 = never auto-lock
     int getAutoLockTimeout(); // Returns timeout in minutes, 0 = disabled
+
+    // User id, theme and auto-lock timeout are read from the database once
+    // per unlock and then served from memory (getAutoLockTimeout runs on
+    // every UI input event). Their setters write through. Changes made by
+    // another process are picked up at the next unlock.
     
     // --- Password History ---
     std::vector<PasswordHistoryEntry> getPasswordHistory(int entryId);
     std::string decryptPasswordFromHistory(const std::string& encryptedPassword);
     
     // --- Recently Accessed Entries ---
+    // Recorded in memory and written to the database in one batch on
+    // flushAccessTimes() (which callers should run periodically), on lock,
+    // and as a fallback by the next access once the oldest unwritten one is
+    // ACCESS_FLUSH_INTERVAL_SECONDS old. Until then only the metadata index
+    // and getRecentlyAccessedEntries see the new access times.
     void updateEntryAccessTime(int entryId);
+    // Served from memory for limit <= EntryAccessLog::RECENT_CAPACITY
     std::vector<VaultEntry> getRecentlyAccessedEntries(int limit = 5);
+    void flushAccessTimes();
+
+    // --- Group Key Cache ---
+    GroupKeyCacheStats getGroupKeyCacheStats() const { return m_groupKeyCache.getStats(); }
+
+    // --- Metadata Index ---
+    // In-memory copy of entry metadata, built at unlock and freed on lock.
+    // getEntries, getEntry, searchEntries, findEntriesByLocation and entryExists read
+    // from it; disabling it sends them back to SQLite. Writes made through
+    // this Vault update it in place. Writes by another connection (another
+    // process on the same file) are merged in on the next read: entries
+    // added or modified since the last sync are re-read and deleted ones
+    // dropped, without a rebuild. Access times written by another process
+    // show up at the next unlock.
+    void setMetadataIndexEnabled(bool enabled);
+    bool isMetadataIndexEnabled() const { return m_metadataIndexEnabled; }
+    MetadataIndexStats getMetadataIndexStats() const { return m_metadataIndex->getStats(); }
+    // Read-only view of the current index that other threads may search
+    // (const members only) while this Vault keeps being used: the Vault
+    // copies the index before changing it while any snapshot is alive.
+    // nullptr when the index is disabled or cannot be built.
+    std::shared_ptr<const MetadataIndex> getMetadataIndexSnapshot();
 
 private:
     std::unique_ptr<Database> m_db;
     std::unique_ptr<Crypto> m_crypto;
-    std::vector<unsigned char> m_masterKey_RAM;
-    std::vector<unsigned char> m_activeGroupKey_RAM;
+    SecureBuffer m_masterKey_RAM;
+    SecureBuffer m_activeGroupKey_RAM;
     int m_activeGroupId;
     std::string m_activeGroupName;
     std::string m_dbPath; 
+    StorageOptions m_storageOptions;
+    int m_kdfTargetMs;
+    // Unwrapped keys of recently used groups; wiped on lock/lockActiveGroup/changeMasterPassword
+    GroupKeyCache m_groupKeyCache;
+    long long m_groupKeysVersion; // Database::getDataVersion() the unwrapped keys were checked at; -1 unknown
+    std::unordered_map<int, std::vector<unsigned char>> m_wrappedGroupKeys; // wrapped blob each unwrapped key came from, by group id
+    std::shared_ptr<MetadataIndex> m_metadataIndex; // never null; shared with snapshots
+    bool m_metadataIndexEnabled;
+    long long m_metadataIndexVersion; // Database::getDataVersion() the index reflects
+    long long m_metadataIndexSyncTime; // wall clock taken just before the last full or incremental read
+    int m_metadataIndexMaxId;          // highest entry id in the database at that read
+    VaultSettings m_settings;
+    bool m_settingsLoaded;
+    std::unordered_map<std::string, GroupAccess> m_groupAccess; // by group name
+    EntryAccessLog m_accessLog;
 
     void checkLocked() const;
     void checkGroupActive() const;
+    void releaseActiveGroup();
+    SecureBuffer unwrapGroupKey(int groupId);
+    void refreshGroupKeys();
+    KdfParams loadKdfParams(bool& stored);
+    UnlockResult unlock(const std::string& path, const std::string& masterPassword,
+                        const std::atomic<bool>* cancelled, const UnlockProgressCallback& onProgress);
+    UnlockResult create(const std::string& path, const std::string& masterPassword,
+                        const std::atomic<bool>* cancelled, const UnlockProgressCallback& onProgress);
+    using OpenJob = UnlockResult (Vault::*)(const std::string&, const std::string&,
+                                            const std::atomic<bool>*, const UnlockProgressCallback&);
+    UnlockHandle runAsync(OpenJob job, const std::string& path, const std::string& masterPassword,
+                          UnlockProgressCallback onProgress, UnlockCompletionCallback onComplete);
+    static DerivedMasterKey deriveMasterKey(const std::string& password, const KdfParams& params);
+    static bool passwordMatches(const std::string& password, const std::vector<unsigned char>& salt,
+                                const KdfParams& params, const std::vector<unsigned char>& canary);
+    void rekeyMaster(const std::string& password, const KdfParams& params);
+    void replaceMasterKey(DerivedMasterKey newKey, const RekeyProgressCallback& onProgress);
+    void buildMetadataIndex();
+    void refreshMetadataIndex();
+    bool metadataIndexReady();
+    MetadataIndex& mutableMetadataIndex();
+    void resetMetadataIndex();
+    void reindexEntry(int entryId);
+    const VaultSettings& settings();
+    void storeSetting(const std::string& key, const std::string& value);
+    const GroupAccess& groupAccess(const std::string& groupName);
+    void invalidateGroupAccess(int groupId);
+    void loadRecentAccesses(int groupId);
 };
 
 }
@@ -32,6 +32,13 @@ struct VaultEntry {
           createdAt(0), lastModified(0), lastAccessed(0), passwordExpiry(0) {}
 };
 
+// One page of a listing ordered by (title, id). Passing nextPageToken back
+// returns the following page; it is empty on the last one.
+struct EntryPage {
+    std::vector<VaultEntry> entries;
+    std::string nextPageToken;
+};
+
 struct PendingInvite {
     int id;
     std::string senderId;
@@ -8,6 +8,10 @@
 #include <QDialogButtonBox>
 #include <QLabel>
 #include <QMessageBox>
+#include <QProgressBar>
+#include <QCoreApplication>
+#include <QPointer>
+#include <thread>
 
 ChangePasswordDialog::ChangePasswordDialog(CipherMesh::Core::Vault* vault, QWidget *parent)
     : QDialog(parent), m_vault(vault)
@@ -47,10 +51,17 @@ ChangePasswordDialog::ChangePasswordDialog(CipherMesh::Core::Vault* vault, QWidg
     formLayout->addRow("New Password:", m_newPasswordEdit);
     formLayout->addRow("Confirm New Password:", m_confirmPasswordEdit);
 
+    m_progressBar = new QProgressBar(this);
+    m_progressBar->setTextVisible(false);
+    m_progressBar->setMaximumHeight(6);
+    m_progressBar->hide();
+
     mainLayout->addLayout(formLayout);
     mainLayout->addWidget(m_messageLabel);
+    mainLayout->addWidget(m_progressBar);
 
     QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    m_buttonBox = buttonBox;
     buttonBox->button(QDialogButtonBox::Ok)->setMinimumWidth(100);
     buttonBox->button(QDialogButtonBox::Ok)->setMinimumHeight(40);
     buttonBox->button(QDialogButtonBox::Cancel)->setMinimumWidth(100);
@@ -67,6 +78,8 @@ ChangePasswordDialog::ChangePasswordDialog(CipherMesh::Core::Vault* vault, QWidg
 }
 
 void ChangePasswordDialog::onOkClicked() {
+    if (m_derive.valid()) return;
+    
     std::string currentPass = m_currentPasswordEdit->text().toStdString();
     std::string newPass = m_newPasswordEdit->text().toStdString();
     std::string confirmPass = m_confirmPasswordEdit->text().toStdString();
@@ -80,29 +93,95 @@ void ChangePasswordDialog::onOkClicked() {
         m_messageLabel->setText("New passwords do not match.");
         return;
     }
+    CipherMesh::Core::Crypto::secureWipe(confirmPass);
     
-    // 2. Verify current password with the core
-    if (!m_vault->verifyMasterPassword(currentPass)) {
+    // 2. Checking the current password and deriving the new key each take
+    // as long as an unlock; both run off the GUI thread and hop back with a
+    // queued call. Re-wrapping the group keys and committing is quick and
+    // stays here.
+    setBusy(true);
+    m_messageLabel->setText("Checking current password and deriving new key...");
+    QPointer<ChangePasswordDialog> self(this);
+    m_derive = m_vault->deriveMasterKeyAsync(currentPass, newPass, [self](CipherMesh::Core::DeriveResult result) {
+        QMetaObject::invokeMethod(qApp, [self, result]() {
+            if (self) self->onKeyDerived(result);
+        }, Qt::QueuedConnection);
+    });
+    CipherMesh::Core::Crypto::secureWipe(currentPass);
+    CipherMesh::Core::Crypto::secureWipe(newPass);
+}
+
+ChangePasswordDialog::~ChangePasswordDialog() {
+    // Only reached with a running worker when the application tears down;
+    // let a detached thread own the future rather than block on it here
+    if (m_derive.valid() && m_derive.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        std::thread([derive = std::move(m_derive)]() mutable { derive.wait(); }).detach();
+    }
+}
+
+void ChangePasswordDialog::reject() {
+    // Cancel is disabled while busy, but Esc and the close button still get
+    // here; waiting for Argon2 would freeze the UI, so stay open instead
+    if (m_derive.valid() && m_derive.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    m_derive = {};
+    QDialog::reject();
+}
+
+void ChangePasswordDialog::onKeyDerived(CipherMesh::Core::DeriveResult result) {
+    using CipherMesh::Core::DeriveResult;
+    if (!m_derive.valid()) {
+        return; // abandoned by reject()
+    }
+    if (result == DeriveResult::WrongPassword) {
+        m_derive = {};
+        setBusy(false);
         m_messageLabel->setText("The current password you entered is incorrect.");
         m_currentPasswordEdit->clear();
         m_currentPasswordEdit->setFocus();
-        CipherMesh::Core::Crypto::secureWipe(currentPass);
-        CipherMesh::Core::Crypto::secureWipe(newPass);
-        CipherMesh::Core::Crypto::secureWipe(confirmPass);
         return;
     }
-    
-    // 3. If valid, attempt to change
-    if (m_vault->changeMasterPassword(newPass)) {
+    bool changed = false;
+    try {
+        m_messageLabel->setText("Re-encrypting group keys...");
+        changed = m_vault->changeMasterPassword(m_derive.get(),
+            [this](CipherMesh::Core::RekeyStage stage, size_t done, size_t total) {
+                onRekeyProgress(stage, done, total);
+            });
+    } catch (const std::exception& e) {
+        // Derivation failed or the vault was locked meanwhile
+    }
+    setBusy(false);
+    if (changed) {
         QMessageBox::information(this, "Success", "Your master password has been changed.");
-        CipherMesh::Core::Crypto::secureWipe(currentPass);
-        CipherMesh::Core::Crypto::secureWipe(newPass);
-        CipherMesh::Core::Crypto::secureWipe(confirmPass);
         accept();
     } else {
+        m_messageLabel->setText("");
         QMessageBox::critical(this, "Error", "An unknown error occurred while changing the password.");
-        CipherMesh::Core::Crypto::secureWipe(currentPass);
-        CipherMesh::Core::Crypto::secureWipe(newPass);
-        CipherMesh::Core::Crypto::secureWipe(confirmPass);
     }
-}
\ No newline at end of file
+}
+
+void ChangePasswordDialog::onRekeyProgress(CipherMesh::Core::RekeyStage stage, size_t done, size_t total) {
+    using CipherMesh::Core::RekeyStage;
+    if (stage == RekeyStage::RewrappingKeys && total > 0) {
+        m_progressBar->setRange(0, static_cast<int>(total));
+        m_progressBar->setValue(static_cast<int>(done));
+    } else if (stage == RekeyStage::Committing) {
+        m_messageLabel->setText("Saving...");
+    }
+    // This runs on the GUI thread between re-wrap steps with no event loop
+    // turn in between, so paint now rather than on a queued update
+    m_progressBar->repaint();
+    m_messageLabel->repaint();
+}
+
+void ChangePasswordDialog::setBusy(bool busy) {
+    m_currentPasswordEdit->setEnabled(!busy);
+    m_newPasswordEdit->setEnabled(!busy);
+    m_confirmPasswordEdit->setEnabled(!busy);
+    m_buttonBox->setEnabled(!busy);
+    m_progressBar->setRange(0, 0); // indeterminate until re-wrapping starts
+    m_progressBar->setVisible(busy);
+    m_messageLabel->setStyleSheet(busy ? "" : "color: #d32f2f;");
+}
@@ -1,25 +1,44 @@
 #pragma once
 
 #include <QDialog>
-
-namespace CipherMesh { namespace Core { class Vault; } }
+#include <future>
+#include "vault.hpp"
 
 class QLineEdit;
 class QLabel;
+class QProgressBar;
+class QDialogButtonBox;
 
 class ChangePasswordDialog : public QDialog {
     Q_OBJECT
 
 public:
     explicit ChangePasswordDialog(CipherMesh::Core::Vault* vault, QWidget *parent = nullptr);
+    ~ChangePasswordDialog();
+
+public slots:
+    // Ignored while the key is being derived (Argon2 cannot be interrupted);
+    // drops a derived key that has not been applied yet
+    void reject() override;
 
 private slots:
     void onOkClicked();
 
 private:
+    // Queued to the GUI thread by the worker once the current password is
+    // checked and the new key derived; the worker may still be returning,
+    // so m_derive.get() can block briefly
+    void onKeyDerived(CipherMesh::Core::DeriveResult result);
+    // Shows re-wrap progress; runs synchronously inside changeMasterPassword
+    void onRekeyProgress(CipherMesh::Core::RekeyStage stage, size_t done, size_t total);
+    void setBusy(bool busy);
+
     CipherMesh::Core::Vault* m_vault;
+    std::future<CipherMesh::Core::DerivedMasterKey> m_derive;
     QLineEdit* m_currentPasswordEdit;
     QLineEdit* m_newPasswordEdit;
     QLineEdit* m_confirmPasswordEdit;
     QLabel* m_messageLabel;
-};
\ No newline at end of file
+    QProgressBar* m_progressBar;
+    QDialogButtonBox* m_buttonBox;
+};
@@ -0,0 +1,155 @@
+#include "entrylistmodel.hpp"
+#include <QColor>
+#include <QDebug>
+#include <algorithm>
+#include <utility>
+
+namespace CipherMesh {
+namespace GUI {
+
+namespace {
+// Rows added per fetchMore; a few screens' worth
+const int FETCH_BATCH_SIZE = 256;
+}
+
+std::vector<EntrySummary> summarizeEntries(const std::vector<Core::VaultEntry>& entries) {
+    std::vector<EntrySummary> summaries;
+    summaries.reserve(entries.size());
+    for (const auto& entry : entries) {
+        summaries.push_back({ entry.id, QString::fromStdString(entry.title), QString::fromStdString(entry.username) });
+    }
+    return summaries;
+}
+
+EntryListModel::EntryListModel(QObject* parent)
+    : QAbstractListModel(parent), m_fetched(0) {}
+
+void EntryListModel::setEntries(std::vector<EntrySummary> entries, const QString& placeholder) {
+    beginResetModel();
+    m_source = nullptr;
+    m_pageToken.clear();
+    m_entries = std::move(entries);
+    m_fetched = std::min(static_cast<int>(m_entries.size()), FETCH_BATCH_SIZE);
+    m_placeholder = placeholder;
+    endResetModel();
+}
+
+void EntryListModel::setPageSource(PageSource source) {
+    Core::EntryPage first = source("");
+    setEntries(summarizeEntries(first.entries));
+    m_source = std::move(source);
+    m_pageToken = first.nextPageToken;
+}
+
+void EntryListModel::clear() {
+    setEntries({});
+}
+
+void EntryListModel::setIcon(const QIcon& icon) {
+    m_icon = icon;
+    if (m_fetched > 0) {
+        emit dataChanged(index(0), index(m_fetched - 1), { Qt::DecorationRole });
+    }
+}
+
+int EntryListModel::entryIdAt(int row) const {
+    if (row < 0 || row >= m_fetched) return -1;
+    return m_entries[row].id;
+}
+
+QString EntryListModel::titleAt(int row) const {
+    if (row < 0 || row >= m_fetched) return QString();
+    return m_entries[row].title;
+}
+
+int EntryListModel::rowForEntryId(int entryId) {
+    size_t searched = 0;
+    do {
+        auto it = std::find_if(m_entries.begin() + searched, m_entries.end(),
+                               [entryId](const EntrySummary& entry) { return entry.id == entryId; });
+        if (it != m_entries.end()) {
+            int row = static_cast<int>(it - m_entries.begin());
+            fetchUpTo(row + 1);
+            return row;
+        }
+        searched = m_entries.size();
+    } while (readNextPage());
+    return -1;
+}
+
+int EntryListModel::rowCount(const QModelIndex& parent) const {
+    if (parent.isValid()) return 0;
+    if (m_entries.empty() && !m_placeholder.isEmpty()) return 1;
+    return m_fetched;
+}
+
+QVariant EntryListModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= rowCount()) return QVariant();
+
+    if (m_entries.empty()) {
+        if (role == Qt::DisplayRole) return m_placeholder;
+        if (role == Qt::ForegroundRole) return QColor("#888888");
+        return QVariant();
+    }
+
+    const EntrySummary& entry = m_entries[index.row()];
+    switch (role) {
+    case Qt::DisplayRole:
+        return entry.title;
+    case Qt::DecorationRole:
+        return m_icon;
+    case UsernameRole:
+        return entry.username;
+    case EntryIdRole:
+        return entry.id;
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags EntryListModel::flags(const QModelIndex& index) const {
+    if (!index.isValid() || m_entries.empty()) {
+        return Qt::NoItemFlags; // the placeholder row is not selectable
+    }
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+bool EntryListModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && (m_fetched < static_cast<int>(m_entries.size()) || !m_pageToken.empty());
+}
+
+void EntryListModel::fetchMore(const QModelIndex& parent) {
+    if (parent.isValid()) return;
+    if (m_fetched == static_cast<int>(m_entries.size())) {
+        readNextPage();
+    }
+    fetchUpTo(m_fetched + FETCH_BATCH_SIZE);
+}
+
+// Appends the next page of m_source to m_entries without exposing the rows
+bool EntryListModel::readNextPage() {
+    if (!m_source || m_pageToken.empty()) return false;
+    try {
+        Core::EntryPage page = m_source(m_pageToken);
+        std::vector<EntrySummary> summaries = summarizeEntries(page.entries);
+        m_entries.insert(m_entries.end(), std::make_move_iterator(summaries.begin()), std::make_move_iterator(summaries.end()));
+        m_pageToken = page.nextPageToken;
+        return true;
+    } catch (const std::exception& e) {
+        // e.g. the vault was locked meanwhile; list what was read so far
+        qWarning() << "Failed to read entries:" << e.what();
+        m_pageToken.clear();
+        return false;
+    }
+}
+
+void EntryListModel::fetchUpTo(int count) {
+    count = std::min(count, static_cast<int>(m_entries.size()));
+    if (count <= m_fetched) return;
+    beginInsertRows(QModelIndex(), m_fetched, count - 1);
+    m_fetched = count;
+    endInsertRows();
+}
+
+} // namespace GUI
+} // namespace CipherMesh
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QIcon>
+#include <QString>
+#include <functional>
+#include <string>
+#include <vector>
+#include "vault_entry.hpp"
+
+namespace CipherMesh {
+namespace GUI {
+
+// What the entry list needs per row; everything else is loaded on selection
+struct EntrySummary {
+    int id;
+    QString title;
+    QString username;
+};
+
+std::vector<EntrySummary> summarizeEntries(const std::vector<Core::VaultEntry>& entries);
+
+// Entries of the current group or search as a flat list of summaries in
+// one array. Rows are handed to the view in batches as it scrolls
+// (canFetchMore/fetchMore); with a page source the summaries themselves
+// are also read a page at a time, so a 100k-entry group costs what has
+// been scrolled through rather than the whole group.
+class EntryListModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Roles {
+        EntryIdRole = Qt::UserRole + 1,
+        UsernameRole
+    };
+
+    // Returns the page after 'pageToken' ("" for the first one)
+    using PageSource = std::function<Core::EntryPage(const std::string& pageToken)>;
+
+    explicit EntryListModel(QObject* parent = nullptr);
+
+    // 'placeholder' is shown as a single disabled row when 'entries' is empty
+    void setEntries(std::vector<EntrySummary> entries, const QString& placeholder = QString());
+    // Lists the pages of 'source', reading the first one now (and letting
+    // its exceptions through) and the rest on demand
+    void setPageSource(PageSource source);
+    void clear();
+    void setIcon(const QIcon& icon);
+
+    // -1 for the placeholder row or an invalid row
+    int entryIdAt(int row) const;
+    QString titleAt(int row) const;
+    // Row of 'entryId', fetching up to it (and reading pages) if needed; -1 if not listed
+    int rowForEntryId(int entryId);
+    size_t entryCount() const { return m_entries.size(); }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+private:
+    void fetchUpTo(int count);
+    bool readNextPage();
+
+    std::vector<EntrySummary> m_entries;
+    int m_fetched;          // rows exposed to the view so far
+    PageSource m_source;
+    std::string m_pageToken; // next page of m_source; empty once all are read
+    QString m_placeholder;
+    QIcon m_icon;
+};
+
+} // namespace GUI
+} // namespace CipherMesh
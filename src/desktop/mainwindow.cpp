@@ -42,10 +42,13 @@
 #include <QLineEdit>
 #include <QSplitter>
 #include <QListWidget>
+#include <QListView>
+#include <QItemSelectionModel>
 #include <QMenu> 
 #include <QTextEdit> 
 #include <QMenuBar> 
 #include <QThread> 
+#include <QThreadPool>
 #include <QObject> 
 #include <QCloseEvent>
 #include <QJsonDocument>
@@ -73,6 +76,13 @@ const QByteArray g_eyeOffIconSvg = R"(<svg xmlns="http://www.w3.org/2000/svg" vi
 const QString INVITE_SUFFIX = " (Invite)";
 const QString COPY_SUFFIX = " (Copy)";
 
+// Quiet period after a keystroke before the search runs
+const int SEARCH_DEBOUNCE_MS = 150;
+// Entries read from the vault at a time while scrolling a group
+const int ENTRY_PAGE_SIZE = 256;
+// How often buffered entry access times are written to the vault file
+const int ACCESS_FLUSH_INTERVAL_MS = 60 * 1000;
+
 MainWindow::MainWindow(const QString& userId, QWidget *parent)
     : QMainWindow(parent),
       m_vault(nullptr),
@@ -82,7 +92,12 @@ MainWindow::MainWindow(const QString& userId, QWidget *parent)
       m_actionIconColor("#ffffff"),
       m_uiIconColor("#e0e0e0"),
       m_autoLockTimer(nullptr),
-      m_recentMenu(nullptr)
+      m_accessFlushTimer(nullptr),
+      m_recentMenu(nullptr),
+      m_searchDebounceTimer(nullptr),
+      m_searchPool(nullptr),
+      m_searchGeneration(0),
+      m_lastSearchRevision(0)
 {
     setWindowTitle("CipherMesh - (Locked) - " + m_currentUserId);
     
@@ -92,6 +107,7 @@ MainWindow::MainWindow(const QString& userId, QWidget *parent)
     
     // Setup auto-lock timer
     setupAutoLockTimer();
+    setupAccessFlushTimer();
     
     m_p2pThread = new QThread(this);
     m_p2pThread->setObjectName("P2PWorkerThread");
@@ -168,6 +184,9 @@ MainWindow::MainWindow(const QString& userId, QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // Search workers use this window until they finish
+    m_searchPool->clear();
+    m_searchPool->waitForDone();
     if (m_p2pThread && m_p2pThread->isRunning()) {
         m_p2pThread->quit();
         m_p2pThread->wait(500);
@@ -497,6 +516,12 @@ void MainWindow::setupUi()
     m_searchEdit = new QLineEdit(this);
     m_searchEdit->setPlaceholderText("Search entries... (Ctrl+F)");
     m_searchEdit->setClearButtonEnabled(true);
+
+    m_searchDebounceTimer = new QTimer(this);
+    m_searchDebounceTimer->setSingleShot(true);
+    m_searchDebounceTimer->setInterval(SEARCH_DEBOUNCE_MS);
+    m_searchPool = new QThreadPool(this);
+    m_searchPool->setMaxThreadCount(1);
     
     m_newEntryButton = new QPushButton("New Entry");
     m_newEntryButton->setObjectName("NewButton"); 
@@ -509,18 +534,17 @@ void MainWindow::setupUi()
     entryButtonLayout->addWidget(m_newEntryButton);
     entryButtonLayout->addStretch(1);
     
-    m_entryListWidget = new QListWidget(this);
-    m_entryListWidget->setObjectName("EntryList"); 
-    m_entryListWidget->setContextMenuPolicy(Qt::CustomContextMenu);
-    m_entryListWidget->setDragEnabled(true);
-    m_entryListWidget->setAcceptDrops(true);
-    m_entryListWidget->setDropIndicatorShown(true);
-    m_entryListWidget->setDefaultDropAction(Qt::MoveAction);
-    m_entryListWidget->setDragDropMode(QAbstractItemView::InternalMove);
-    connect(m_entryListWidget, &QListWidget::customContextMenuRequested, this, &MainWindow::onEntryContextMenuRequested);
+    m_entryModel = new CipherMesh::GUI::EntryListModel(this);
+    m_entryListView = new QListView(this);
+    m_entryListView->setObjectName("EntryList"); 
+    m_entryListView->setModel(m_entryModel);
+    m_entryListView->setUniformItemSizes(true); // row layout stays O(1) for large groups
+    m_entryListView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_entryListView->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(m_entryListView, &QListView::customContextMenuRequested, this, &MainWindow::onEntryContextMenuRequested);
     
     entryLayout->addWidget(m_searchEdit); 
-    entryLayout->addWidget(m_entryListWidget, 1); 
+    entryLayout->addWidget(m_entryListView, 1); 
     entryLayout->addLayout(entryButtonLayout); 
 
     // --- Details Pane ---
@@ -685,7 +709,7 @@ void MainWindow::setupUi()
     setCentralWidget(m_mainSplitter);
 
     connect(m_groupListWidget, &QListWidget::currentItemChanged, this, &MainWindow::onGroupSelected);
-    connect(m_entryListWidget, &QListWidget::currentItemChanged, this, &MainWindow::onEntrySelected);
+    connect(m_entryListView->selectionModel(), &QItemSelectionModel::currentChanged, this, &MainWindow::onEntrySelected);
     connect(m_copyUsernameButton, &QPushButton::clicked, this, &MainWindow::onCopyUsername);
     connect(m_copyPasswordButton, &QPushButton::clicked, this, &MainWindow::onCopyPassword);
     connect(m_showPasswordButton, &QPushButton::toggled, this, &MainWindow::onToggleShowPassword);
@@ -698,6 +722,7 @@ void MainWindow::setupUi()
     connect(m_viewHistoryButton, &QPushButton::clicked, this, &MainWindow::onViewPasswordHistoryClicked);
     
     connect(m_searchEdit, &QLineEdit::textChanged, this, &MainWindow::onSearchTextChanged); 
+    connect(m_searchDebounceTimer, &QTimer::timeout, this, &MainWindow::startSearch);
     connect(m_settingsButton, &QPushButton::clicked, this, &MainWindow::onSettingsButtonClicked); 
 }
 
@@ -742,8 +767,7 @@ void MainWindow::postUnlockInit()
 void MainWindow::loadGroups()
 {
     m_groupListWidget->clear();
-    m_entryListWidget->clear(); 
-    m_entryMap.clear();
+    m_entryModel->clear();
     m_pendingInviteMap.clear(); 
     m_detailsStack->setCurrentIndex(0); 
     
@@ -775,8 +799,10 @@ void MainWindow::loadGroups()
 
 void MainWindow::onGroupSelected(QListWidgetItem* current)
 {
-    m_entryListWidget->clear();
-    m_entryMap.clear();
+    // A pending or running search must not replace the group's entries
+    m_searchDebounceTimer->stop();
+    ++m_searchGeneration;
+    m_entryModel->clear();
     
     if (!current || !m_vault) {
         m_newEntryButton->setEnabled(false); 
@@ -818,13 +844,15 @@ void MainWindow::onGroupSelected(QListWidgetItem* current)
     
     try {
         if (m_vault->setActiveGroup(groupName)) {
-            QIcon entryIcon = loadSvgIcon(g_keyIconSvg, m_uiIconColor); 
-            std::vector<CipherMesh::Core::VaultEntry> entries = m_vault->getEntries();
-            for (const auto& entry : entries) {
-                QListWidgetItem* item = new QListWidgetItem(entryIcon, QString::fromStdString(entry.title));
-                m_entryListWidget->addItem(item);
-                m_entryMap[item] = entry;
-            }
+            m_entryModel->setIcon(loadSvgIcon(g_keyIconSvg, m_uiIconColor));
+            int groupId = m_vault->getActiveGroupId();
+            m_entryModel->setPageSource([this, groupId](const std::string& pageToken) {
+                // Pages resume the active group's listing; stop if that changed
+                if (m_vault->getActiveGroupId() != groupId) {
+                    throw std::runtime_error("Active group changed");
+                }
+                return m_vault->getEntriesPage(ENTRY_PAGE_SIZE, pageToken);
+            });
             
             // Update recent menu when group changes
             updateRecentMenu();
@@ -859,10 +887,10 @@ void MainWindow::onGroupContextMenuRequested(const QPoint &pos)
 
 void MainWindow::onEntryContextMenuRequested(const QPoint &pos)
 {
-    QListWidgetItem* item = m_entryListWidget->itemAt(pos);
-    if (!item) return; 
+    QModelIndex index = m_entryListView->indexAt(pos);
+    if (m_entryModel->entryIdAt(index.row()) == -1) return; 
 
-    m_entryListWidget->setCurrentItem(item);
+    m_entryListView->setCurrentIndex(index);
 
     QMenu contextMenu(this);
     
@@ -889,12 +917,14 @@ void MainWindow::onEntryContextMenuRequested(const QPoint &pos)
     connect(duplicateAction, &QAction::triggered, this, &MainWindow::onDuplicateEntryClicked);
     connect(deleteAction, &QAction::triggered, this, &MainWindow::onDeleteEntryClicked);
 
-    contextMenu.exec(m_entryListWidget->mapToGlobal(pos));
+    contextMenu.exec(m_entryListView->viewport()->mapToGlobal(pos));
 }
 
-void MainWindow::onEntrySelected(QListWidgetItem* current)
+void MainWindow::onEntrySelected(const QModelIndex& current)
 {
-    if (!current || !m_vault) {
+    int entryId = m_entryModel->entryIdAt(current.row());
+    if (entryId == -1 || !m_vault) {
+        m_currentEntry = CipherMesh::Core::VaultEntry();
         m_detailsStack->setCurrentIndex(0); 
         
         m_editEntryButton->setEnabled(false);
@@ -907,10 +937,16 @@ void MainWindow::onEntrySelected(QListWidgetItem* current)
     m_deleteEntryButton->setEnabled(true);
     m_viewHistoryButton->setEnabled(true);
 
-    auto it = m_entryMap.find(current);
-    if (it == m_entryMap.end()) return; 
-
-    const CipherMesh::Core::VaultEntry& entry = it.value();
+    // The list only holds summaries; notes, locations and timestamps are read now
+    try {
+        m_currentEntry = m_vault->getEntry(entryId);
+    } catch (const std::exception& e) {
+        qWarning() << "Failed to load entry:" << e.what();
+        m_currentEntry = CipherMesh::Core::VaultEntry();
+        m_detailsStack->setCurrentIndex(0);
+        return;
+    }
+    const CipherMesh::Core::VaultEntry& entry = m_currentEntry;
     
     // Track entry access time
     try {
@@ -959,60 +995,100 @@ void MainWindow::onEntrySelected(QListWidgetItem* current)
     m_detailsStack->setCurrentIndex(1);
 }
 
-void MainWindow::loadEntries(const std::vector<CipherMesh::Core::VaultEntry>& entries)
+void MainWindow::loadEntries(std::vector<CipherMesh::GUI::EntrySummary> entries)
 {
-    m_entryListWidget->clear();
-    m_entryMap.clear();
     m_detailsStack->setCurrentIndex(0);
-    
-    QIcon entryIcon = loadSvgIcon(g_keyIconSvg, m_uiIconColor); 
-
-    for (const auto& entry : entries) {
-        QListWidgetItem* item = new QListWidgetItem(entryIcon, QString::fromStdString(entry.title));
-        m_entryListWidget->addItem(item);
-        m_entryMap[item] = entry;
-    }
-    
-    // Add empty state message if no entries exist
-    if (m_entryListWidget->count() == 0) {
-        QListWidgetItem* emptyItem = new QListWidgetItem("No entries yet - click 'New Entry' or press Ctrl+N to add one");
-        emptyItem->setFlags(Qt::NoItemFlags); // Make it non-selectable
-        emptyItem->setForeground(QColor("#888888"));
-        m_entryListWidget->addItem(emptyItem);
-    }
+    m_entryModel->setIcon(loadSvgIcon(g_keyIconSvg, m_uiIconColor));
+    // Empty state message if no entries exist
+    m_entryModel->setEntries(std::move(entries), "No entries yet - click 'New Entry' or press Ctrl+N to add one");
 }
 
 void MainWindow::onSearchTextChanged(const QString& text)
 {
     if (!m_vault) return;
 
+    // Whatever is queued or running is out of date now
+    ++m_searchGeneration;
+    m_searchPool->clear();
+
     if (text.isEmpty()) {
+        m_searchDebounceTimer->stop();
+        m_lastSearchTerm.clear();
         if (m_groupListWidget->currentItem()) {
             onGroupSelected(m_groupListWidget->currentItem());
         } else {
-            m_entryListWidget->clear();
-            m_entryMap.clear();
+            m_entryModel->clear();
         }
     } else {
-        try {
-            std::vector<CipherMesh::Core::VaultEntry> entries = m_vault->searchEntries(text.toStdString());
-            loadEntries(entries);
-            m_newEntryButton->setEnabled(false); 
-        } catch (const std::exception& e) {
-            QMessageBox::critical(this, "Error Searching", e.what());
+        m_searchDebounceTimer->start();
+    }
+}
+
+// Runs the search for the current text once typing pauses. With the
+// metadata index it runs on m_searchPool against an index snapshot, so the
+// vault stays usable meanwhile; otherwise it falls back to SQLite here.
+void MainWindow::startSearch()
+{
+    if (!m_vault || m_vault->isLocked()) return;
+    QString text = m_searchEdit->text();
+    if (text.isEmpty()) return;
+
+    quint64 generation = ++m_searchGeneration;
+    std::string term = text.toStdString();
+    std::shared_ptr<const CipherMesh::Core::MetadataIndex> index;
+    try {
+        index = m_vault->getMetadataIndexSnapshot();
+        if (!index) {
+            applySearchResults(generation, text, CipherMesh::GUI::summarizeEntries(m_vault->searchEntries(term)), nullptr);
+            return;
         }
+    } catch (const std::exception& e) {
+        QMessageBox::critical(this, "Error Searching", e.what());
+        return;
     }
+
+    // Typing more of the same term only has to look at the entries already
+    // listed, as long as nothing changed in the index since
+    bool narrow = !m_lastSearchTerm.isEmpty() &&
+                  m_lastSearchIndex.lock() == index &&
+                  index->revision() == m_lastSearchRevision &&
+                  CipherMesh::Core::MetadataIndex::narrows(m_lastSearchTerm.toStdString(), term);
+    std::vector<int> withinIds;
+    if (narrow) withinIds = m_lastSearchIds;
+
+    m_searchPool->start([this, generation, text, term, index, narrow, withinIds]() {
+        if (generation != m_searchGeneration) return; // superseded before it started
+        std::vector<CipherMesh::GUI::EntrySummary> entries = CipherMesh::GUI::summarizeEntries(
+            narrow ? index->searchEntries(term, withinIds) : index->searchEntries(term));
+        QMetaObject::invokeMethod(this, [this, generation, text, index, entries = std::move(entries)]() mutable {
+            applySearchResults(generation, text, std::move(entries), index);
+        }, Qt::QueuedConnection);
+    });
 }
 
-int MainWindow::getSelectedEntryId()
+void MainWindow::applySearchResults(quint64 generation, const QString& term,
+                                    std::vector<CipherMesh::GUI::EntrySummary> entries,
+                                    const std::shared_ptr<const CipherMesh::Core::MetadataIndex>& index)
 {
-    QListWidgetItem* currentItem = m_entryListWidget->currentItem();
-    if (!currentItem) return -1;
+    // Newer keystrokes, a group change or a lock came in while this ran
+    if (generation != m_searchGeneration || !m_vault || m_vault->isLocked()) return;
+
+    m_lastSearchTerm = term;
+    m_lastSearchIndex = index;
+    m_lastSearchRevision = index ? index->revision() : 0;
+    m_lastSearchIds.clear();
+    m_lastSearchIds.reserve(entries.size());
+    for (const auto& entry : entries) {
+        m_lastSearchIds.push_back(entry.id);
+    }
 
-    auto it = m_entryMap.find(currentItem);
-    if (it == m_entryMap.end()) return -1;
+    loadEntries(std::move(entries));
+    m_newEntryButton->setEnabled(false); 
+}
 
-    return it.value().id;
+int MainWindow::getSelectedEntryId()
+{
+    return m_entryModel->entryIdAt(m_entryListView->currentIndex().row());
 }
 
 QString MainWindow::getSelectedGroupName()
@@ -1183,7 +1259,7 @@ void MainWindow::onDeleteEntryClicked()
         QMessageBox::warning(this, "Error", "No entry selected.");
         return;
     }
-    QString entryTitle = m_entryListWidget->currentItem()->text();
+    QString entryTitle = m_entryModel->titleAt(m_entryListView->currentIndex().row());
     QMessageBox::StandardButton reply = QMessageBox::question(this, "Delete Entry",
                                   QString("Are you sure you want to permanently delete the entry '%1'?").arg(entryTitle),
                                   QMessageBox::Yes | QMessageBox::No);
@@ -1213,7 +1289,8 @@ void MainWindow::onEditEntryClicked()
         QMessageBox::warning(this, "Error", "No entry selected to edit.");
         return;
     }
-    const CipherMesh::Core::VaultEntry& entry = m_entryMap[m_entryListWidget->currentItem()];
+    if (m_currentEntry.id != entryId) return;
+    const CipherMesh::Core::VaultEntry& entry = m_currentEntry;
     // Updated constructor usage:
     NewEntryDialog dialog(m_vault, entry, this); 
     if (dialog.exec() == QDialog::Accepted) {
@@ -1245,7 +1322,8 @@ void MainWindow::onDuplicateEntryClicked()
     }
     
     try {
-        const CipherMesh::Core::VaultEntry& originalEntry = m_entryMap[m_entryListWidget->currentItem()];
+        if (m_currentEntry.id != entryId) return;
+        const CipherMesh::Core::VaultEntry& originalEntry = m_currentEntry;
         
         // Create a copy with modified title
         CipherMesh::Core::VaultEntry duplicateEntry = originalEntry;
@@ -1347,7 +1425,7 @@ void MainWindow::handleDataRequested(const QString& requesterId, const QString&
 
     // B. Export FRESH data from Vault
     try {
-        std::vector<unsigned char> key = m_vault->getGroupKey(groupName.toStdString());
+        std::vector<unsigned char> key = m_vault->getGroupKey(groupName.toStdString()).toVector();
         std::vector<CipherMesh::Core::VaultEntry> entries = m_vault->exportGroupEntries(groupName.toStdString());
         
         // C. Send the data directly via P2P (not through invite flow)
@@ -1373,23 +1451,34 @@ void MainWindow::restoreOutgoingInvites() {
     
     for (const std::string& groupName : groups) {
         auto members = m_vault->getGroupMembers(groupName);
+        
+        // Export each group at most once, however many invites are pending
+        bool exported = false;
+        std::vector<unsigned char> key;
+        std::vector<CipherMesh::Core::VaultEntry> entries;
         for (const auto& member : members) {
             // If we sent an invite but they haven't accepted yet
             if (member.status == "pending") {
                 try {
                     // Re-export the latest data to ensure they get the freshest version
-                    std::vector<unsigned char> key = m_vault->getGroupKey(groupName);
-                    std::vector<CipherMesh::Core::VaultEntry> entries = m_vault->exportGroupEntries(groupName);
+                    if (!exported) {
+                        key = m_vault->getGroupKey(groupName).toVector();
+                        entries = m_vault->exportGroupEntries(groupName);
+                        exported = true;
+                    }
                     
                     // Queue it up!
                     p2p->queueInvite(groupName, member.userId, key, entries);
-                    
-                    CipherMesh::Core::Crypto::secureWipe(key);
                 } catch (...) {
                     qWarning() << "Failed to restore invite for" << QString::fromStdString(member.userId);
                 }
             }
         }
+        
+        CipherMesh::Core::Crypto::secureWipe(key);
+        for (auto& entry : entries) {
+            CipherMesh::Core::Crypto::secureWipe(entry.password);
+        }
     }
 }
 
@@ -1457,22 +1546,37 @@ void MainWindow::onAutoLockTimeout() {
 void MainWindow::onAutoLockTimeoutChanged(int minutes) {
     resetAutoLockTimer();
 }
-void MainWindow::onViewPasswordHistoryClicked() {
+
+// --- ACCESS TIME FLUSH ---
+// The vault buffers access times and only writes them on its own when
+// another access comes in; this writes them while the window sits idle
+void MainWindow::setupAccessFlushTimer() {
+    m_accessFlushTimer = new QTimer(this);
+    connect(m_accessFlushTimer, &QTimer::timeout, this, &MainWindow::onAccessFlushTimeout);
+    m_accessFlushTimer->start(ACCESS_FLUSH_INTERVAL_MS);
+}
+
+void MainWindow::onAccessFlushTimeout() {
     if (!m_vault || m_vault->isLocked()) {
         return;
     }
-    
-    QListWidgetItem* currentItem = m_entryListWidget->currentItem();
-    if (!currentItem) {
+    try {
+        m_vault->flushAccessTimes();
+    } catch (const std::exception& e) {
+        qWarning() << "Failed to write entry access times:" << e.what();
+    }
+}
+void MainWindow::onViewPasswordHistoryClicked() {
+    if (!m_vault || m_vault->isLocked()) {
         return;
     }
     
-    auto it = m_entryMap.find(currentItem);
-    if (it == m_entryMap.end()) {
+    int entryId = getSelectedEntryId();
+    if (entryId == -1 || m_currentEntry.id != entryId) {
         return;
     }
     
-    const CipherMesh::Core::VaultEntry& entry = it.value();
+    const CipherMesh::Core::VaultEntry& entry = m_currentEntry;
     
     // Update access time
     if (m_vault) {
@@ -1529,12 +1633,10 @@ void MainWindow::onRecentEntrySelected() {
     int entryId = action->data().toInt();
     
     // Find and select the entry in the current list
-    for (int j = 0; j < m_entryListWidget->count(); ++j) {
-        QListWidgetItem* item = m_entryListWidget->item(j);
-        auto it = m_entryMap.find(item);
-        if (it != m_entryMap.end() && it.value().id == entryId) {
-            m_entryListWidget->setCurrentRow(j);
-            break;
-        }
+    int row = m_entryModel->rowForEntryId(entryId);
+    if (row != -1) {
+        QModelIndex index = m_entryModel->index(row);
+        m_entryListView->setCurrentIndex(index);
+        m_entryListView->scrollTo(index);
     }
 }
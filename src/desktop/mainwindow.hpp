@@ -5,8 +5,14 @@
 #include <QListWidgetItem>
 #include "vault_entry.hpp"
 #include "ip2pservice.hpp" 
+#include "entrylistmodel.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
 
 class QListWidget;
+class QListView;
+class QModelIndex;
 class QStackedWidget;
 class QLineEdit;
 class QPushButton;
@@ -18,8 +24,10 @@ class QPoint;
 class QTextEdit; 
 class QLabel; 
 class QThread; 
+class QThreadPool;
+class QTimer;
 
-namespace CipherMesh { namespace Core { class Vault; } }
+namespace CipherMesh { namespace Core { class Vault; class MetadataIndex; } }
 namespace CipherMesh { namespace P2P { class IP2PService; } } 
 
 class MainWindow : public QMainWindow {
@@ -39,7 +47,7 @@ private slots:
     void postUnlockInit();
     void loadGroups();
     void onGroupSelected(QListWidgetItem* current);
-    void onEntrySelected(QListWidgetItem* current);
+    void onEntrySelected(const QModelIndex& current);
     void onCopyUsername();
     void onCopyPassword();
     void onToggleShowPassword(bool checked);
@@ -86,7 +94,11 @@ private:
     void updateWindowTitle(); // NEW: Update window title with lock status
     void updateRecentMenu(); // NEW: Update recently accessed entries menu
 
-    void loadEntries(const std::vector<CipherMesh::Core::VaultEntry>& entries); 
+    void loadEntries(std::vector<CipherMesh::GUI::EntrySummary> entries); 
+    void startSearch();
+    void applySearchResults(quint64 generation, const QString& term,
+                            std::vector<CipherMesh::GUI::EntrySummary> entries,
+                            const std::shared_ptr<const CipherMesh::Core::MetadataIndex>& index);
     QIcon loadSvgIcon(const QByteArray& svgData, const QColor& color);
     int getSelectedEntryId();
     QString getSelectedGroupName();
@@ -98,7 +110,8 @@ private:
     QLabel* m_connectionStatusLabel;  // NEW: Connection status indicator
     
     QLineEdit* m_searchEdit; 
-    QListWidget* m_entryListWidget;
+    QListView* m_entryListView;
+    CipherMesh::GUI::EntryListModel* m_entryModel;
     QPushButton* m_newEntryButton;
     
     QStackedWidget* m_detailsStack;
@@ -127,7 +140,7 @@ private:
     CipherMesh::P2P::IP2PService* m_p2pService; 
     QThread* m_p2pThread; 
 
-    QMap<QListWidgetItem*, CipherMesh::Core::VaultEntry> m_entryMap;
+    CipherMesh::Core::VaultEntry m_currentEntry; // details of the selected row, loaded on selection
     QMap<QListWidgetItem*, int> m_pendingInviteMap;
 
     bool m_isPasswordVisible;
@@ -141,12 +154,27 @@ private:
     QTimer* m_autoLockTimer;
     void resetAutoLockTimer();
     void setupAutoLockTimer();
+
+    // Writes buffered entry access times periodically
+    QTimer* m_accessFlushTimer;
+    void setupAccessFlushTimer();
     
     // --- NEW: Recently accessed menu ---
     QMenu* m_recentMenu;
     void onRecentEntrySelected();
+
+    // --- Search-as-you-type ---
+    QTimer* m_searchDebounceTimer;
+    QThreadPool* m_searchPool;               // single worker; queued searches are dropped, not run
+    std::atomic<quint64> m_searchGeneration; // bumped per search; older results are discarded
+    // What the list shows for the last search, so a longer term can narrow it
+    QString m_lastSearchTerm;
+    std::weak_ptr<const CipherMesh::Core::MetadataIndex> m_lastSearchIndex;
+    unsigned long long m_lastSearchRevision;
+    std::vector<int> m_lastSearchIds;
     
 private slots:
     void onAutoLockTimeout();
     void onAutoLockTimeoutChanged(int minutes);
+    void onAccessFlushTimeout();
 };
\ No newline at end of file
@@ -321,7 +321,8 @@ void ShareGroupDialog::onInviteClicked() {
             m_statusLabel->setText("Preparing data...");
             
             try {
-                std::vector<unsigned char> key = m_vault->getGroupKey(m_groupName.toStdString());
+                // The P2P layer serializes plain bytes; wiped below
+                std::vector<unsigned char> key = m_vault->getGroupKey(m_groupName.toStdString()).toVector();
                 std::vector<CipherMesh::Core::VaultEntry> entries = m_vault->exportGroupEntries(m_groupName.toStdString());
                 
                 m_statusLabel->setText("Sending invite...");
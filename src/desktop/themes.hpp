@@ -26,7 +26,7 @@ const QString Style_Professional = R"(
     }
     
     /* Lists */
-    QListWidget { 
+    QListWidget, QListView#EntryList { 
         background-color: #1e1e1e; 
         color: #e0e0e0; 
         border: 1px solid #2a2a2a; 
@@ -35,17 +35,17 @@ const QString Style_Professional = R"(
         outline: none; 
         padding: 6px;
     }
-    QListWidget::item { 
+    QListWidget::item, QListView#EntryList::item { 
         padding: 11px 12px; 
         border-radius: 6px;
         margin: 1px 0px;
     }
-    QListWidget::item:selected { 
+    QListWidget::item:selected, QListView#EntryList::item:selected { 
         background-color: #264f78; 
         color: #ffffff; 
         font-weight: 500;
     }
-    QListWidget::item:hover { 
+    QListWidget::item:hover, QListView#EntryList::item:hover { 
         background-color: #282828; 
     }
     
@@ -324,7 +324,7 @@ const QString Style_ModernLight = R"(
     }
     
     /* Lists */
-    QListWidget { 
+    QListWidget, QListView#EntryList { 
         background-color: #ffffff; 
         color: #1a1a1a; 
         border: 1px solid #d4d4d4; 
@@ -333,17 +333,17 @@ const QString Style_ModernLight = R"(
         outline: none; 
         padding: 6px;
     }
-    QListWidget::item { 
+    QListWidget::item, QListView#EntryList::item { 
         padding: 11px 12px; 
         border-radius: 6px;
         margin: 1px 0px;
     }
-    QListWidget::item:selected { 
+    QListWidget::item:selected, QListView#EntryList::item:selected { 
         background-color: #0078d4;
         color: #ffffff; 
         font-weight: 500;
     }
-    QListWidget::item:hover { 
+    QListWidget::item:hover, QListView#EntryList::item:hover { 
         background-color: #f0f0f0; 
     }
 
@@ -623,7 +623,7 @@ const QString Style_OceanDark = R"(
     }
     
     /* Lists */
-    QListWidget { 
+    QListWidget, QListView#EntryList { 
         background-color: #0d2238; 
         color: #b2bac2; 
         border: 1px solid #1e3a52; 
@@ -632,18 +632,18 @@ const QString Style_OceanDark = R"(
         outline: none; 
         padding: 6px;
     }
-    QListWidget::item { 
+    QListWidget::item, QListView#EntryList::item { 
         padding: 11px 12px; 
         border-radius: 6px;
         margin: 1px 0px;
     }
-    QListWidget::item:selected { 
+    QListWidget::item:selected, QListView#EntryList::item:selected { 
         background-color: #0c4a6e; 
         color: #ffffff; 
         border-left: 3px solid #0ea5e9;
         font-weight: 500;
     }
-    QListWidget::item:hover { 
+    QListWidget::item:hover, QListView#EntryList::item:hover { 
         background-color: #133554; 
     }
     
@@ -918,7 +918,7 @@ const QString Style_WarmLight = R"(
     }
     
     /* Lists */
-    QListWidget { 
+    QListWidget, QListView#EntryList { 
         background-color: #ffffff; 
         color: #292524; 
         border: 1px solid #e7e5e4; 
@@ -927,18 +927,18 @@ const QString Style_WarmLight = R"(
         outline: none; 
         padding: 6px;
     }
-    QListWidget::item { 
+    QListWidget::item, QListView#EntryList::item { 
         padding: 11px 12px; 
         border-radius: 6px;
         margin: 1px 0px;
     }
-    QListWidget::item:selected { 
+    QListWidget::item:selected, QListView#EntryList::item:selected { 
         background-color: #fed7aa; 
         color: #7c2d12; 
         border-left: 3px solid #ea580c;
         font-weight: 500;
     }
-    QListWidget::item:hover { 
+    QListWidget::item:hover, QListView#EntryList::item:hover { 
         background-color: #fef3c7; 
     }
     
@@ -1212,7 +1212,7 @@ const QString Style_VibrantColors = R"(
     }
     
     /* Lists */
-    QListWidget { 
+    QListWidget, QListView#EntryList { 
         background-color: #ffffff; 
         color: #1f2937; 
         border: 1px solid #e5e7eb; 
@@ -1221,17 +1221,17 @@ const QString Style_VibrantColors = R"(
         outline: none; 
         padding: 6px;
     }
-    QListWidget::item { 
+    QListWidget::item, QListView#EntryList::item { 
         padding: 11px 12px; 
         border-radius: 6px;
         margin: 1px 0px;
     }
-    QListWidget::item:selected { 
+    QListWidget::item:selected, QListView#EntryList::item:selected { 
         background-color: #ec4899; 
         color: #ffffff; 
         font-weight: 500;
     }
-    QListWidget::item:hover:!selected { 
+    QListWidget::item:hover:!selected, QListView#EntryList::item:hover:!selected { 
         background-color: #f3f4f6; 
     }
     
@@ -9,17 +9,31 @@
 #include <QDialogButtonBox>
 #include <QLabel>
 #include <QStackedWidget>
+#include <QProgressBar>
 #include <QFile>
+#include <QCoreApplication>
+#include <QPointer>
 #include <sqlite3.h>
 #include <string>
 #include <vector>
 #include <cctype>
 #include <cstdio>
+#include <functional>
+#include <thread>
+
+// Queues 'call' to the GUI thread from a worker. The dialog may be gone by
+// the time it runs, so it is only reached through a QPointer there.
+static void postToDialog(QPointer<UnlockDialog> dialog, std::function<void(UnlockDialog&)> call) {
+    QMetaObject::invokeMethod(qApp, [dialog, call]() {
+        if (dialog) call(*dialog);
+    }, Qt::QueuedConnection);
+}
 
 UnlockDialog::UnlockDialog(CipherMesh::Core::Vault* vault, QWidget *parent)
     : QDialog(parent),
       m_vault(vault),
-      m_vaultPath("ciphermesh.db") {
+      m_vaultPath("ciphermesh.db"),
+      m_closeWhenFinished(false) {
     setWindowTitle("CipherMesh - Unlock");
     setModal(true);
     setMinimumWidth(500);
@@ -48,7 +62,40 @@ UnlockDialog::UnlockDialog(CipherMesh::Core::Vault* vault, QWidget *parent)
     }
 }
 
-UnlockDialog::~UnlockDialog() {}
+UnlockDialog::~UnlockDialog() {
+    // Only reached with a running worker when the application tears down.
+    // The last handle copy waits for the worker, so give it to a detached
+    // thread instead of blocking the event loop here; its callbacks find
+    // the dialog gone and do nothing.
+    if (m_unlock.isValid() && !m_unlock.isFinished()) {
+        m_unlock.cancel();
+        std::thread([unlock = m_unlock]() { unlock.wait(); }).detach();
+    }
+}
+
+void UnlockDialog::reject() {
+    if (m_unlock.isValid() && !m_unlock.isFinished()) {
+        // Argon2 cannot be interrupted: ask the worker to stop at its next
+        // stage and close from the completion handler
+        m_unlock.cancel();
+        m_closeWhenFinished = true;
+        currentMessageLabel()->setText("Cancelling...");
+        return;
+    }
+    QDialog::reject();
+}
+
+bool UnlockDialog::closeIfRejected(CipherMesh::Core::UnlockResult result) {
+    if (!m_closeWhenFinished) {
+        return false;
+    }
+    m_closeWhenFinished = false;
+    if (result == CipherMesh::Core::UnlockResult::Unlocked) {
+        m_vault->lock(); // finished before it saw the cancel
+    }
+    QDialog::reject();
+    return true;
+}
 
 bool UnlockDialog::isVaultInitialized() {
     if (!QFile::exists(QString::fromStdString(m_vaultPath))) return false;
@@ -96,16 +143,24 @@ void UnlockDialog::createUnlockView() {
     m_unlockPasswordEdit->setMinimumHeight(40);
     layout->addWidget(m_unlockPasswordEdit);
     
-    QPushButton* unlockButton = new QPushButton("Unlock Vault", this);
-    unlockButton->setObjectName("NewButton");
-    unlockButton->setDefault(true);
-    unlockButton->setMinimumHeight(40);
-    layout->addWidget(unlockButton);
+    m_unlockButton = new QPushButton("Unlock Vault", this);
+    m_unlockButton->setObjectName("NewButton");
+    m_unlockButton->setDefault(true);
+    m_unlockButton->setMinimumHeight(40);
+    layout->addWidget(m_unlockButton);
+    
+    // Busy indicator while the key is derived in the background
+    m_unlockProgressBar = new QProgressBar(this);
+    m_unlockProgressBar->setRange(0, 0);
+    m_unlockProgressBar->setTextVisible(false);
+    m_unlockProgressBar->setMaximumHeight(6);
+    m_unlockProgressBar->hide();
+    layout->addWidget(m_unlockProgressBar);
     
     layout->addStretch();
     m_stack->addWidget(view);
     
-    connect(unlockButton, &QPushButton::clicked, this, &UnlockDialog::onUnlockClicked);
+    connect(m_unlockButton, &QPushButton::clicked, this, &UnlockDialog::onUnlockClicked);
     connect(m_unlockPasswordEdit, &QLineEdit::returnPressed, this, &UnlockDialog::onUnlockClicked);
 }
 
@@ -161,38 +216,110 @@ void UnlockDialog::createCreateView() {
     mainLayout->addLayout(layout);
     mainLayout->addSpacing(10);
     
-    QPushButton* createButton = new QPushButton("Create Vault", this);
-    createButton->setObjectName("NewButton");
-    createButton->setDefault(true);
-    createButton->setMinimumHeight(40);
-    mainLayout->addWidget(createButton);
+    m_createButton = new QPushButton("Create Vault", this);
+    m_createButton->setObjectName("NewButton");
+    m_createButton->setDefault(true);
+    m_createButton->setMinimumHeight(40);
+    mainLayout->addWidget(m_createButton);
+    
+    // Busy indicator while the KDF is calibrated and the key derived
+    m_createProgressBar = new QProgressBar(this);
+    m_createProgressBar->setRange(0, 0);
+    m_createProgressBar->setTextVisible(false);
+    m_createProgressBar->setMaximumHeight(6);
+    m_createProgressBar->hide();
+    mainLayout->addWidget(m_createProgressBar);
     
     mainLayout->addStretch();
     
     m_stack->addWidget(view);
     
-    connect(createButton, &QPushButton::clicked, this, &UnlockDialog::onCreateClicked);
+    connect(m_createButton, &QPushButton::clicked, this, &UnlockDialog::onCreateClicked);
     connect(m_createUsernameEdit, &QLineEdit::returnPressed, this, &UnlockDialog::onCreateClicked);
     connect(m_createPasswordEdit, &QLineEdit::returnPressed, this, &UnlockDialog::onCreateClicked);
     connect(m_confirmPasswordEdit, &QLineEdit::returnPressed, this, &UnlockDialog::onCreateClicked);
 }
 
 void UnlockDialog::onUnlockClicked() {
+    if (m_unlock.isValid() && !m_unlock.isFinished()) return;
+    
     std::string password = m_unlockPasswordEdit->text().toStdString();
-    if (m_vault->loadVault(m_vaultPath, password)) {
-        CipherMesh::Core::Crypto::secureWipe(password);
-        m_unlockPasswordEdit->clear();
+    m_unlockPasswordEdit->clear();
+    setUnlockBusy(true);
+    
+    // Key derivation takes hundreds of milliseconds; run it off the GUI
+    // thread and hop back with queued calls
+    QPointer<UnlockDialog> self(this);
+    m_unlock = m_vault->loadVaultAsync(m_vaultPath, password,
+        [self](CipherMesh::Core::UnlockStage stage) {
+            postToDialog(self, [stage](UnlockDialog& dialog) { dialog.onUnlockProgress(stage); });
+        },
+        [self](CipherMesh::Core::UnlockResult result) {
+            postToDialog(self, [result](UnlockDialog& dialog) { dialog.onUnlockFinished(result); });
+        });
+    CipherMesh::Core::Crypto::secureWipe(password);
+}
+
+void UnlockDialog::onUnlockProgress(CipherMesh::Core::UnlockStage stage) {
+    using CipherMesh::Core::UnlockStage;
+    if (m_closeWhenFinished) {
+        return; // keep showing "Cancelling..."
+    }
+    QLabel* label = currentMessageLabel();
+    switch (stage) {
+        case UnlockStage::OpeningVault: label->setText("Opening vault..."); break;
+        case UnlockStage::CalibratingKdf: label->setText("Measuring device speed..."); break;
+        case UnlockStage::DerivingKey: label->setText("Deriving key..."); break;
+        case UnlockStage::VerifyingKey: label->setText("Verifying password..."); break;
+        case UnlockStage::UpgradingKdf: label->setText("Upgrading vault security..."); break;
+        case UnlockStage::LoadingIndex: label->setText("Loading entries..."); break;
+        case UnlockStage::Finished: break;
+    }
+}
+
+QLabel* UnlockDialog::currentMessageLabel() const {
+    return m_stack->currentIndex() == 0 ? m_unlockMessageLabel : m_createMessageLabel;
+}
+
+void UnlockDialog::onUnlockFinished(CipherMesh::Core::UnlockResult result) {
+    using CipherMesh::Core::UnlockResult;
+    setUnlockBusy(false);
+    if (closeIfRejected(result)) {
+        return;
+    }
+    if (result == UnlockResult::Unlocked) {
         accept();
-    } else {
+        return;
+    }
+    
+    if (result == UnlockResult::WrongPassword) {
         m_unlockMessageLabel->setText("Invalid password. Try again.");
-        m_unlockMessageLabel->setStyleSheet("color: #ff5555;");
-        m_unlockPasswordEdit->clear();
-        m_unlockPasswordEdit->setFocus();
+    } else if (result == UnlockResult::Cancelled) {
+        m_unlockMessageLabel->setText("Unlock cancelled.");
+    } else {
+        m_unlockMessageLabel->setText("Could not open vault.");
+    }
+    m_unlockMessageLabel->setStyleSheet("color: #ff5555;");
+    m_unlockPasswordEdit->setFocus();
+}
+
+void UnlockDialog::setUnlockBusy(bool busy) {
+    m_unlockPasswordEdit->setEnabled(!busy);
+    m_unlockButton->setEnabled(!busy);
+    m_unlockProgressBar->setVisible(busy && m_stack->currentIndex() == 0);
+    m_createUsernameEdit->setEnabled(!busy);
+    m_createPasswordEdit->setEnabled(!busy);
+    m_confirmPasswordEdit->setEnabled(!busy);
+    m_createButton->setEnabled(!busy);
+    m_createProgressBar->setVisible(busy && m_stack->currentIndex() == 1);
+    if (busy) {
+        currentMessageLabel()->setStyleSheet("");
     }
-    CipherMesh::Core::Crypto::secureWipe(password);
 }
 
 void UnlockDialog::onCreateClicked() {
+    if (m_unlock.isValid() && !m_unlock.isFinished()) return;
+    
     std::string username = m_createUsernameEdit->text().trimmed().toStdString();
     std::string p1 = m_createPasswordEdit->text().toStdString();
     std::string p2 = m_confirmPasswordEdit->text().toStdString();
@@ -211,6 +338,8 @@ void UnlockDialog::onCreateClicked() {
         m_createMessageLabel->setText("Passwords do not match. Try again.");
         m_createMessageLabel->setStyleSheet("color: #ff5555;");
         m_confirmPasswordEdit->clear();
+        CipherMesh::Core::Crypto::secureWipe(p1);
+        CipherMesh::Core::Crypto::secureWipe(p2);
         return;
     }
     
@@ -228,9 +357,34 @@ void UnlockDialog::onCreateClicked() {
     if (sanitized.length() > 12) {
         sanitized = sanitized.substr(0, 12);
     }
-    
-    try {
-        if (m_vault->createNewVault(m_vaultPath, p1)) {
+    m_createUsername = sanitized;
+    
+    m_createPasswordEdit->clear();
+    m_confirmPasswordEdit->clear();
+    setUnlockBusy(true);
+    
+    // Calibrating the KDF and deriving the key take a second or more; run
+    // them off the GUI thread like an unlock
+    QPointer<UnlockDialog> self(this);
+    m_unlock = m_vault->createNewVaultAsync(m_vaultPath, p1,
+        [self](CipherMesh::Core::UnlockStage stage) {
+            postToDialog(self, [stage](UnlockDialog& dialog) { dialog.onUnlockProgress(stage); });
+        },
+        [self](CipherMesh::Core::UnlockResult result) {
+            postToDialog(self, [result](UnlockDialog& dialog) { dialog.onCreateFinished(result); });
+        });
+    CipherMesh::Core::Crypto::secureWipe(p1);
+    CipherMesh::Core::Crypto::secureWipe(p2);
+}
+
+void UnlockDialog::onCreateFinished(CipherMesh::Core::UnlockResult result) {
+    using CipherMesh::Core::UnlockResult;
+    setUnlockBusy(false);
+    if (closeIfRejected(result)) {
+        return;
+    }
+    if (result == UnlockResult::Unlocked) {
+        try {
             // Generate user ID: username_<16 hex chars>
             std::vector<unsigned char> randomBytes = CipherMesh::Core::Crypto::randomBytes(8);
             std::string hexSuffix;
@@ -239,25 +393,22 @@ void UnlockDialog::onCreateClicked() {
                 snprintf(hex, sizeof(hex), "%02x", byte);
                 hexSuffix += hex;
             }
-            std::string userId = sanitized + "_" + hexSuffix;
+            std::string userId = m_createUsername + "_" + hexSuffix;
             
             // Store username and user ID in vault
             m_vault->setUserId(userId);
             
-            CipherMesh::Core::Crypto::secureWipe(p1);
-            CipherMesh::Core::Crypto::secureWipe(p2);
             m_createUsernameEdit->clear();
-            m_createPasswordEdit->clear();
-            m_confirmPasswordEdit->clear();
             accept();
-        } else {
-            m_createMessageLabel->setText("An error occurred. Could not create vault.");
-            m_createMessageLabel->setStyleSheet("color: #ff5555;");
+            return;
+        } catch (const std::exception& e) {
+            m_createMessageLabel->setText(QString("Error: %1").arg(e.what()));
         }
-    } catch (const std::exception& e) {
-        m_createMessageLabel->setText(QString("Error: %1").arg(e.what()));
-        m_createMessageLabel->setStyleSheet("color: #ff5555;");
+    } else if (result == UnlockResult::Cancelled) {
+        m_createMessageLabel->setText("Vault creation cancelled.");
+    } else {
+        m_createMessageLabel->setText("An error occurred. Could not create vault.");
     }
-    CipherMesh::Core::Crypto::secureWipe(p1);
-    CipherMesh::Core::Crypto::secureWipe(p2);
-}
\ No newline at end of file
+    m_createMessageLabel->setStyleSheet("color: #ff5555;");
+    m_createPasswordEdit->setFocus();
+}
@@ -2,12 +2,13 @@
 
 #include <QDialog>
 #include <string>
+#include "vault.hpp"
 
 class QStackedWidget;
 class QLineEdit;
 class QLabel;
-
-namespace CipherMesh { namespace Core { class Vault; } }
+class QPushButton;
+class QProgressBar;
 
 class UnlockDialog : public QDialog {
     Q_OBJECT
@@ -16,6 +17,11 @@ public:
     explicit UnlockDialog(CipherMesh::Core::Vault* vault, QWidget *parent = nullptr);
     ~UnlockDialog();
 
+public slots:
+    // While an unlock or vault creation runs, asks it to stop and closes once
+    // the worker reports back; never waits on the GUI thread
+    void reject() override;
+
 private slots:
     void onUnlockClicked();
     void onCreateClicked();
@@ -24,15 +30,30 @@ private:
     bool isVaultInitialized();
     void createUnlockView();
     void createCreateView();
+    // Called on the GUI thread for progress/completion of m_unlock, which
+    // runs either an unlock or the creation of a new vault
+    void onUnlockProgress(CipherMesh::Core::UnlockStage stage);
+    void onUnlockFinished(CipherMesh::Core::UnlockResult result);
+    void onCreateFinished(CipherMesh::Core::UnlockResult result);
+    void setUnlockBusy(bool busy);
+    QLabel* currentMessageLabel() const;
+    bool closeIfRejected(CipherMesh::Core::UnlockResult result);
 
     CipherMesh::Core::Vault* m_vault;
     std::string m_vaultPath;
+    CipherMesh::Core::UnlockHandle m_unlock;
+    std::string m_createUsername; // sanitized, while a vault is being created
+    bool m_closeWhenFinished;     // reject() came in while m_unlock was running
 
     QStackedWidget* m_stack;
     QLineEdit* m_unlockPasswordEdit;
     QLabel* m_unlockMessageLabel;
+    QPushButton* m_unlockButton;
+    QProgressBar* m_unlockProgressBar;
     QLineEdit* m_createUsernameEdit;
     QLineEdit* m_createPasswordEdit;
     QLineEdit* m_confirmPasswordEdit;
     QLabel* m_createMessageLabel;
+    QPushButton* m_createButton;
+    QProgressBar* m_createProgressBar;
 };
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "groupdatacodec.hpp"
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonValue>
+#include <utility>
+
+namespace CipherMesh {
+namespace P2P {
+
+QJsonObject encodeGroupData(const QString& groupName,
+                            const std::vector<unsigned char>& groupKey,
+                            const std::vector<CipherMesh::Core::VaultEntry>& entries) {
+    QJsonObject keyMsg;
+    keyMsg["type"] = "group-data";
+    keyMsg["group"] = groupName;
+    
+    // 1. Encode Key
+    QByteArray keyBytes(reinterpret_cast<const char*>(groupKey.data()), groupKey.size());
+    keyMsg["key"] = QString(keyBytes.toBase64());
+    
+    // 2. Encode Entries
+    QJsonArray entriesArr;
+    for (const auto& entry : entries) {
+        QJsonObject eObj;
+        eObj["title"] = QString::fromStdString(entry.title);
+        eObj["username"] = QString::fromStdString(entry.username);
+        eObj["password"] = QString::fromStdString(entry.password);
+        eObj["notes"] = QString::fromStdString(entry.notes);
+        
+        QJsonArray locArr;
+        for (const auto& l : entry.locations) {
+            QJsonObject lObj;
+            lObj["type"] = QString::fromStdString(l.type);
+            lObj["value"] = QString::fromStdString(l.value);
+            locArr.append(lObj);
+        }
+        eObj["locations"] = locArr;
+        entriesArr.append(eObj);
+    }
+    keyMsg["entries"] = entriesArr;
+    return keyMsg;
+}
+
+void decodeGroupData(const QJsonObject& message,
+                     QString& groupName,
+                     std::vector<unsigned char>& groupKey,
+                     std::vector<CipherMesh::Core::VaultEntry>& entries) {
+    groupName = message["group"].toString();
+    QByteArray keyBytes = QByteArray::fromBase64(message["key"].toString().toUtf8());
+    groupKey.assign(keyBytes.begin(), keyBytes.end());
+    
+    QJsonArray entriesArr = message["entries"].toArray();
+    entries.clear();
+    entries.reserve(entriesArr.size());
+    for (const auto& val : entriesArr) {
+        QJsonObject eObj = val.toObject();
+        CipherMesh::Core::VaultEntry e;
+        e.title = eObj["title"].toString().toStdString();
+        e.username = eObj["username"].toString().toStdString();
+        e.password = eObj["password"].toString().toStdString();
+        e.notes = eObj["notes"].toString().toStdString();
+        
+        QJsonArray locArr = eObj["locations"].toArray();
+        for (const auto& lVal : locArr) {
+            QJsonObject lObj = lVal.toObject();
+            CipherMesh::Core::Location l;
+            l.type = lObj["type"].toString().toStdString();
+            l.value = lObj["value"].toString().toStdString();
+            e.locations.push_back(l);
+        }
+        entries.push_back(std::move(e));
+    }
+}
+
+}
+}
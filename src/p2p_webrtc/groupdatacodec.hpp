@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <vector>
+
+#include "vault_entry.hpp"
+
+namespace CipherMesh {
+namespace P2P {
+
+// Builds the "group-data" P2P message carrying a shared group's key
+// (base64) and its entries, passwords included.
+QJsonObject encodeGroupData(const QString& groupName,
+                            const std::vector<unsigned char>& groupKey,
+                            const std::vector<CipherMesh::Core::VaultEntry>& entries);
+
+// Reverse of encodeGroupData. Entries come back without ids.
+void decodeGroupData(const QJsonObject& message,
+                     QString& groupName,
+                     std::vector<unsigned char>& groupKey,
+                     std::vector<CipherMesh::Core::VaultEntry>& entries);
+
+}
+}
@@ -1,4 +1,5 @@
 #include "webrtcservice.hpp"
+#include "groupdatacodec.hpp"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
@@ -556,37 +557,9 @@ void WebRTCService::handleP2PMessage(const QString& remoteId, const QString& mes
     else if (type == "invite-accept") {
         if (m_pendingInvites.contains(remoteId)) {
             qDebug() << "DEBUG: Invite accepted! Sending group data...";
-            QJsonObject keyMsg;
-            keyMsg["type"] = "group-data";
-            keyMsg["group"] = m_pendingInvites[remoteId];
-            
-            // 1. Encode Key
-            std::vector<unsigned char>& key = m_pendingKeys[remoteId];
-            QByteArray keyBytes(reinterpret_cast<const char*>(key.data()), key.size());
-            keyMsg["key"] = QString(keyBytes.toBase64());
-            
-            // 2. Encode Entries
-            QJsonArray entriesArr;
-            std::vector<CipherMesh::Core::VaultEntry>& entries = m_pendingEntries[remoteId];
-            for (const auto& entry : entries) {
-                QJsonObject eObj;
-                eObj["title"] = QString::fromStdString(entry.title);
-                eObj["username"] = QString::fromStdString(entry.username);
-                eObj["password"] = QString::fromStdString(entry.password); 
-                eObj["notes"] = QString::fromStdString(entry.notes);
-                
-                QJsonArray locArr;
-                for (const auto& l : entry.locations) {
-                    QJsonObject lObj;
-                    lObj["type"] = QString::fromStdString(l.type);
-                    lObj["value"] = QString::fromStdString(l.value);
-                    locArr.append(lObj); 
-                }
-                eObj["locations"] = locArr;
-                entriesArr.append(eObj);
-            }
-            keyMsg["entries"] = entriesArr;
-
+            QJsonObject keyMsg = CipherMesh::P2P::encodeGroupData(m_pendingInvites[remoteId],
+                                                                  m_pendingKeys[remoteId],
+                                                                  m_pendingEntries[remoteId]);
             sendP2PMessage(remoteId, keyMsg);
             
             if (onInviteStatus) onInviteStatus(true, "Transfer complete!");
@@ -619,32 +592,10 @@ void WebRTCService::handleP2PMessage(const QString& remoteId, const QString& mes
     }
     else if (type == "group-data") {
         qDebug() << "DEBUG: Received GROUP DATA!";
-        QString groupName = obj["group"].toString();
-        QString keyBase64 = obj["key"].toString();
-        QByteArray keyBytes = QByteArray::fromBase64(keyBase64.toUtf8());
-        std::vector<unsigned char> rawKey(keyBytes.begin(), keyBytes.end());
-        
-        QJsonArray entriesArr = obj["entries"].toArray();
+        QString groupName;
+        std::vector<unsigned char> rawKey;
         std::vector<CipherMesh::Core::VaultEntry> importedEntries;
-        
-        for (const auto& val : entriesArr) {
-            QJsonObject eObj = val.toObject();
-            CipherMesh::Core::VaultEntry e;
-            e.title = eObj["title"].toString().toStdString();
-            e.username = eObj["username"].toString().toStdString();
-            e.password = eObj["password"].toString().toStdString();
-            e.notes = eObj["notes"].toString().toStdString();
-            
-            QJsonArray locArr = eObj["locations"].toArray();
-            for (const auto& lVal : locArr) {
-                QJsonObject lObj = lVal.toObject();
-                CipherMesh::Core::Location l;
-                l.type = lObj["type"].toString().toStdString();
-                l.value = lObj["value"].toString().toStdString();
-                e.locations.push_back(l);
-            }
-            importedEntries.push_back(e);
-        }
+        CipherMesh::P2P::decodeGroupData(obj, groupName, rawKey, importedEntries);
         // Pass SENDER ID correctly here
         if (onGroupDataReceived) {
             onGroupDataReceived(remoteId.toStdString(), groupName.toStdString(), rawKey, importedEntries);
@@ -996,34 +947,7 @@ void WebRTCService::sendGroupData(const std::string& recipientId,
     qDebug() << "DEBUG: Sending group data to" << remoteId << "for group" << groupNameQt;
     
     // Build the group-data message
-    QJsonObject keyMsg;
-    keyMsg["type"] = "group-data";
-    keyMsg["group"] = groupNameQt;
-    
-    // 1. Encode Key
-    QByteArray keyBytes(reinterpret_cast<const char*>(groupKey.data()), groupKey.size());
-    keyMsg["key"] = QString(keyBytes.toBase64());
-    
-    // 2. Encode Entries
-    QJsonArray entriesArr;
-    for (const auto& entry : entries) {
-        QJsonObject eObj;
-        eObj["title"] = QString::fromStdString(entry.title);
-        eObj["username"] = QString::fromStdString(entry.username);
-        eObj["password"] = QString::fromStdString(entry.password);
-        eObj["notes"] = QString::fromStdString(entry.notes);
-        
-        QJsonArray locArr;
-        for (const auto& l : entry.locations) {
-            QJsonObject lObj;
-            lObj["type"] = QString::fromStdString(l.type);
-            lObj["value"] = QString::fromStdString(l.value);
-            locArr.append(lObj);
-        }
-        eObj["locations"] = locArr;
-        entriesArr.append(eObj);
-    }
-    keyMsg["entries"] = entriesArr;
+    QJsonObject keyMsg = CipherMesh::P2P::encodeGroupData(groupNameQt, groupKey, entries);
     
     // Send the message
     sendP2PMessage(remoteId, keyMsg);